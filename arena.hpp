@@ -0,0 +1,277 @@
+//
+// block allocation for values that have to outlive the reader
+//
+
+#ifndef SERIALIZE_ARENA_HPP
+#define SERIALIZE_ARENA_HPP
+#include <string.h>
+#include <stdint.h>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if ((defined(__cplusplus) && __cplusplus >= 201703L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)) && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define IGUANA_HAS_MEMORY_RESOURCE
+#endif
+#endif
+
+namespace iguana {
+	//hands out memory from large blocks, all of which are freed together when the
+	//arena is cleared or destroyed; nothing is freed one by one
+	class arena
+	{
+	public:
+		static constexpr std::size_t default_block_size = 4096;
+
+		explicit arena(std::size_t block_size = default_block_size)
+			: m_ptr(nullptr)
+			, m_end(nullptr)
+			, m_block_size(block_size)
+			, m_size(0)
+		{
+		}
+
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		//the blocks move over; other is left empty, as if newly constructed
+		arena(arena&& other)
+			: m_blocks(std::move(other.m_blocks))
+			, m_ptr(other.m_ptr)
+			, m_end(other.m_end)
+			, m_block_size(other.m_block_size)
+			, m_size(other.m_size)
+		{
+			other.reset();
+		}
+
+		//frees what this arena handed out before taking over other's blocks
+		arena& operator=(arena&& other)
+		{
+			if (this != &other)
+			{
+				this->m_blocks = std::move(other.m_blocks);
+				this->m_ptr = other.m_ptr;
+				this->m_end = other.m_end;
+				this->m_block_size = other.m_block_size;
+				this->m_size = other.m_size;
+				other.reset();
+			}
+			return *this;
+		}
+
+		char * allocate(std::size_t len, std::size_t align = 1)
+		{
+			std::size_t pad = (align - reinterpret_cast<uintptr_t>(this->m_ptr) % align) % align;
+			if (static_cast<std::size_t>(this->m_end - this->m_ptr) < len + pad)
+			{
+				//oversized requests get a block of their own
+				std::size_t size = len + align > this->m_block_size ? len + align : this->m_block_size;
+				this->m_blocks.emplace_back(new char[size]);
+				this->m_ptr = this->m_blocks.back().get();
+				this->m_end = this->m_ptr + size;
+				pad = (align - reinterpret_cast<uintptr_t>(this->m_ptr) % align) % align;
+			}
+			char * p = this->m_ptr + pad;
+			this->m_ptr = p + len;
+			this->m_size += len;
+			return p;
+		}
+
+		const char * copy(const char * data, std::size_t len)
+		{
+			char * p = allocate(len);
+			std::memcpy(p, data, len);
+			return p;
+		}
+
+		void clear()
+		{
+			this->m_blocks.clear();
+			this->m_ptr = nullptr;
+			this->m_end = nullptr;
+			this->m_size = 0;
+		}
+
+		//bytes handed out since the last clear
+		inline std::size_t size() const
+		{
+			return this->m_size;
+		}
+
+	private:
+		void reset()
+		{
+			clear();
+			this->m_block_size = default_block_size;
+		}
+
+		std::vector<std::unique_ptr<char[]>> m_blocks;
+		char * m_ptr;
+		char * m_end;
+		std::size_t m_block_size;
+		std::size_t m_size;
+	};
+
+	namespace detail {
+		inline arena *& current_arena()
+		{
+			static thread_local arena * current = nullptr;
+			return current;
+		}
+	}
+
+	//default constructed arena_allocators on this thread draw from a until the
+	//scope ends
+	class arena_scope
+	{
+	public:
+		explicit arena_scope(arena& a)
+			: m_prev(detail::current_arena())
+		{
+			detail::current_arena() = &a;
+		}
+
+		arena_scope(const arena_scope&) = delete;
+		arena_scope& operator=(const arena_scope&) = delete;
+
+		~arena_scope()
+		{
+			detail::current_arena() = m_prev;
+		}
+
+	private:
+		arena * m_prev;
+	};
+
+	//allocates from an arena and never frees, or from the heap when there is no
+	//arena. a default constructed one takes the current arena of the thread, so
+	//strings and containers created while reading land in the same arena as the
+	//container holding them. the arena must not be cleared or moved while
+	//containers using it are alive
+	template<typename T>
+	class arena_allocator
+	{
+	public:
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		arena_allocator() noexcept
+			: m_arena(detail::current_arena())
+		{
+		}
+
+		arena_allocator(arena& a) noexcept
+			: m_arena(&a)
+		{
+		}
+
+		template<typename U>
+		arena_allocator(const arena_allocator<U>& other) noexcept
+			: m_arena(other.resource())
+		{
+		}
+
+		T * allocate(std::size_t n)
+		{
+			if (this->m_arena == nullptr)
+				return static_cast<T *>(::operator new(n * sizeof(T)));
+			return reinterpret_cast<T *>(this->m_arena->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T * p, std::size_t) noexcept
+		{
+			if (this->m_arena == nullptr)
+				::operator delete(p);
+		}
+
+		inline arena * resource() const noexcept
+		{
+			return this->m_arena;
+		}
+
+	private:
+		arena * m_arena;
+	};
+
+	template<typename T, typename U>
+	inline bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept
+	{
+		return a.resource() == b.resource();
+	}
+
+	template<typename T, typename U>
+	inline bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept
+	{
+		return a.resource() != b.resource();
+	}
+
+	namespace detail {
+		template<typename C, typename A>
+		inline void adopt_arena(C&, const A&)
+		{
+		}
+
+		template<typename C, typename U>
+		inline void adopt_arena(C& c, const arena_allocator<U>& a)
+		{
+			if (current_arena() != nullptr && a.resource() != current_arena())
+				c = C(typename C::allocator_type());
+		}
+
+		template<typename C>
+		inline auto adopt_current_arena(C& c, int) -> decltype(c.get_allocator(), void())
+		{
+			adopt_arena(c, c.get_allocator());
+		}
+
+		//container adaptors have no allocator of their own to replace
+		template<typename C>
+		inline void adopt_current_arena(C&, long)
+		{
+		}
+
+		//a string or an empty container the caller constructed before the read
+		//started still points to the heap or to another arena, give it the current
+		//one before filling it. does nothing outside an arena_scope
+		template<typename C>
+		inline void adopt_current_arena(C& c)
+		{
+			adopt_current_arena(c, 0);
+		}
+	}
+
+#ifdef IGUANA_HAS_MEMORY_RESOURCE
+	//lets std::pmr containers allocate from an arena
+	class arena_resource : public std::pmr::memory_resource
+	{
+	public:
+		explicit arena_resource(arena& a)
+			: m_arena(a)
+		{
+		}
+
+	private:
+		void * do_allocate(std::size_t bytes, std::size_t align) override
+		{
+			return this->m_arena.allocate(bytes, align);
+		}
+
+		void do_deallocate(void *, std::size_t, std::size_t) override
+		{
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+		arena& m_arena;
+	};
+#endif
+}
+#endif //SERIALIZE_ARENA_HPP
@@ -0,0 +1,469 @@
+//
+// Shortest round-trip floating point to ascii conversion (Grisu2).
+//
+// The digit generation follows Florian Loitsch, "Printing Floating-Point
+// Numbers Quickly and Accurately with Integers" (PLDI 2010), with the
+// boundary handling used by Milo Yip's and Niels Lohmann's implementations.
+// The result always reads back to the same value and is the shortest such
+// representation for the vast majority of inputs.
+//
+
+#ifndef SERIALIZE_DTOA_HPP
+#define SERIALIZE_DTOA_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "itoa.hpp"
+
+namespace iguana {
+	namespace detail {
+		namespace dtoa {
+			struct diyfp {
+				uint64_t f;
+				int e;
+
+				static diyfp sub(const diyfp& x, const diyfp& y) {
+					return { x.f - y.f, x.e };
+				}
+
+				// upper 64 bits of the 128 bit product, rounded
+				static diyfp mul(const diyfp& x, const diyfp& y) {
+					const uint64_t u_lo = x.f & 0xFFFFFFFFu;
+					const uint64_t u_hi = x.f >> 32;
+					const uint64_t v_lo = y.f & 0xFFFFFFFFu;
+					const uint64_t v_hi = y.f >> 32;
+
+					const uint64_t p0 = u_lo * v_lo;
+					const uint64_t p1 = u_lo * v_hi;
+					const uint64_t p2 = u_hi * v_lo;
+					const uint64_t p3 = u_hi * v_hi;
+
+					uint64_t q = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+					q += uint64_t{ 1 } << 31;
+
+					return { p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32), x.e + y.e + 64 };
+				}
+
+				static diyfp normalize(diyfp x) {
+					while ((x.f >> 63) == 0) {
+						x.f <<= 1;
+						x.e--;
+					}
+					return x;
+				}
+
+				static diyfp normalize_to(const diyfp& x, int target_exponent) {
+					return { x.f << (x.e - target_exponent), target_exponent };
+				}
+			};
+
+			struct boundaries {
+				diyfp w;
+				diyfp minus;
+				diyfp plus;
+			};
+
+			// v = w, with m- and m+ the midpoints to the neighbouring floats,
+			// computed in the precision of T so that float gets its own shortest form
+			template<typename T>
+			boundaries compute_boundaries(T value) {
+				constexpr int precision = std::numeric_limits<T>::digits;
+				constexpr int bias = std::numeric_limits<T>::max_exponent - 1 + (precision - 1);
+				constexpr int min_exp = 1 - bias;
+				constexpr uint64_t hidden_bit = uint64_t{ 1 } << (precision - 1);
+
+				using bits_type = std::conditional_t<precision == 24, uint32_t, uint64_t>;
+				bits_type bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+
+				const uint64_t E = bits >> (precision - 1);
+				const uint64_t F = bits & (hidden_bit - 1);
+
+				const diyfp v = E == 0 ? diyfp{ F, min_exp } : diyfp{ F + hidden_bit, static_cast<int>(E) - bias };
+				const bool lower_boundary_is_closer = F == 0 && E > 1;
+
+				const diyfp m_plus{ 2 * v.f + 1, v.e - 1 };
+				const diyfp m_minus = lower_boundary_is_closer
+					? diyfp{ 4 * v.f - 1, v.e - 2 }
+					: diyfp{ 2 * v.f - 1, v.e - 1 };
+
+				const diyfp w_plus = diyfp::normalize(m_plus);
+				const diyfp w_minus = diyfp::normalize_to(m_minus, w_plus.e);
+				return { diyfp::normalize(v), w_minus, w_plus };
+			}
+
+			struct cached_power {
+				uint64_t f;
+				int e;
+				int k;
+			};
+
+			constexpr int alpha = -60;
+			constexpr int gamma = -32;
+
+			// c = 10^k normalized, for k = -300, -292, ..., 324
+			inline cached_power get_cached_power_for_binary_exponent(int e) {
+				static constexpr cached_power cached_powers[] = {
+				{ 0xAB70FE17C79AC6CA, -1060, -300 },
+				{ 0xFF77B1FCBEBCDC4F, -1034, -292 },
+				{ 0xBE5691EF416BD60C, -1007, -284 },
+				{ 0x8DD01FAD907FFC3C,  -980, -276 },
+				{ 0xD3515C2831559A83,  -954, -268 },
+				{ 0x9D71AC8FADA6C9B5,  -927, -260 },
+				{ 0xEA9C227723EE8BCB,  -901, -252 },
+				{ 0xAECC49914078536D,  -874, -244 },
+				{ 0x823C12795DB6CE57,  -847, -236 },
+				{ 0xC21094364DFB5637,  -821, -228 },
+				{ 0x9096EA6F3848984F,  -794, -220 },
+				{ 0xD77485CB25823AC7,  -768, -212 },
+				{ 0xA086CFCD97BF97F4,  -741, -204 },
+				{ 0xEF340A98172AACE5,  -715, -196 },
+				{ 0xB23867FB2A35B28E,  -688, -188 },
+				{ 0x84C8D4DFD2C63F3B,  -661, -180 },
+				{ 0xC5DD44271AD3CDBA,  -635, -172 },
+				{ 0x936B9FCEBB25C996,  -608, -164 },
+				{ 0xDBAC6C247D62A584,  -582, -156 },
+				{ 0xA3AB66580D5FDAF6,  -555, -148 },
+				{ 0xF3E2F893DEC3F126,  -529, -140 },
+				{ 0xB5B5ADA8AAFF80B8,  -502, -132 },
+				{ 0x87625F056C7C4A8B,  -475, -124 },
+				{ 0xC9BCFF6034C13053,  -449, -116 },
+				{ 0x964E858C91BA2655,  -422, -108 },
+				{ 0xDFF9772470297EBD,  -396, -100 },
+				{ 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+				{ 0xF8A95FCF88747D94,  -343,  -84 },
+				{ 0xB94470938FA89BCF,  -316,  -76 },
+				{ 0x8A08F0F8BF0F156B,  -289,  -68 },
+				{ 0xCDB02555653131B6,  -263,  -60 },
+				{ 0x993FE2C6D07B7FAC,  -236,  -52 },
+				{ 0xE45C10C42A2B3B06,  -210,  -44 },
+				{ 0xAA242499697392D3,  -183,  -36 },
+				{ 0xFD87B5F28300CA0E,  -157,  -28 },
+				{ 0xBCE5086492111AEB,  -130,  -20 },
+				{ 0x8CBCCC096F5088CC,  -103,  -12 },
+				{ 0xD1B71758E219652C,   -77,   -4 },
+				{ 0x9C40000000000000,   -50,    4 },
+				{ 0xE8D4A51000000000,   -24,   12 },
+				{ 0xAD78EBC5AC620000,     3,   20 },
+				{ 0x813F3978F8940984,    30,   28 },
+				{ 0xC097CE7BC90715B3,    56,   36 },
+				{ 0x8F7E32CE7BEA5C70,    83,   44 },
+				{ 0xD5D238A4ABE98068,   109,   52 },
+				{ 0x9F4F2726179A2245,   136,   60 },
+				{ 0xED63A231D4C4FB27,   162,   68 },
+				{ 0xB0DE65388CC8ADA8,   189,   76 },
+				{ 0x83C7088E1AAB65DB,   216,   84 },
+				{ 0xC45D1DF942711D9A,   242,   92 },
+				{ 0x924D692CA61BE758,   269,  100 },
+				{ 0xDA01EE641A708DEA,   295,  108 },
+				{ 0xA26DA3999AEF774A,   322,  116 },
+				{ 0xF209787BB47D6B85,   348,  124 },
+				{ 0xB454E4A179DD1877,   375,  132 },
+				{ 0x865B86925B9BC5C2,   402,  140 },
+				{ 0xC83553C5C8965D3D,   428,  148 },
+				{ 0x952AB45CFA97A0B3,   455,  156 },
+				{ 0xDE469FBD99A05FE3,   481,  164 },
+				{ 0xA59BC234DB398C25,   508,  172 },
+				{ 0xF6C69A72A3989F5C,   534,  180 },
+				{ 0xB7DCBF5354E9BECE,   561,  188 },
+				{ 0x88FCF317F22241E2,   588,  196 },
+				{ 0xCC20CE9BD35C78A5,   614,  204 },
+				{ 0x98165AF37B2153DF,   641,  212 },
+				{ 0xE2A0B5DC971F303A,   667,  220 },
+				{ 0xA8D9D1535CE3B396,   694,  228 },
+				{ 0xFB9B7CD9A4A7443C,   720,  236 },
+				{ 0xBB764C4CA7A44410,   747,  244 },
+				{ 0x8BAB8EEFB6409C1A,   774,  252 },
+				{ 0xD01FEF10A657842C,   800,  260 },
+				{ 0x9B10A4E5E9913129,   827,  268 },
+				{ 0xE7109BFBA19C0C9D,   853,  276 },
+				{ 0xAC2820D9623BF429,   880,  284 },
+				{ 0x80444B5E7AA7CF85,   907,  292 },
+				{ 0xBF21E44003ACDD2D,   933,  300 },
+				{ 0x8E679C2F5E44FF8F,   960,  308 },
+				{ 0xD433179D9C8CB841,   986,  316 },
+				{ 0x9E19DB92B4E31BA9,  1013,  324 }
+				};
+
+				constexpr int min_dec_exp = -300;
+				constexpr int dec_step = 8;
+
+				// k = ceil((alpha - e - 1) * log10(2))
+				const int f = alpha - e - 1;
+				const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+				const int index = (-min_dec_exp + k + (dec_step - 1)) / dec_step;
+				return cached_powers[index];
+			}
+
+			inline int find_largest_pow10(uint32_t n, uint32_t& pow10) {
+				if (n >= 1000000000) { pow10 = 1000000000; return 10; }
+				if (n >= 100000000) { pow10 = 100000000; return 9; }
+				if (n >= 10000000) { pow10 = 10000000; return 8; }
+				if (n >= 1000000) { pow10 = 1000000; return 7; }
+				if (n >= 100000) { pow10 = 100000; return 6; }
+				if (n >= 10000) { pow10 = 10000; return 5; }
+				if (n >= 1000) { pow10 = 1000; return 4; }
+				if (n >= 100) { pow10 = 100; return 3; }
+				if (n >= 10) { pow10 = 10; return 2; }
+				pow10 = 1;
+				return 1;
+			}
+
+			inline void grisu2_round(char* buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+				// move the last digit towards w while it stays inside the unsafe interval
+				while (rest < dist && delta - rest >= ten_k &&
+					(rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+					buf[len - 1]--;
+					rest += ten_k;
+				}
+			}
+
+			inline void grisu2_digit_gen(char* buffer, int& length, int& decimal_exponent, diyfp m_minus, diyfp w, diyfp m_plus) {
+				uint64_t delta = diyfp::sub(m_plus, m_minus).f;
+				uint64_t dist = diyfp::sub(m_plus, w).f;
+
+				const diyfp one{ uint64_t{ 1 } << -m_plus.e, m_plus.e };
+
+				uint32_t p1 = static_cast<uint32_t>(m_plus.f >> -one.e);
+				uint64_t p2 = m_plus.f & (one.f - 1);
+
+				uint32_t pow10;
+				int n = find_largest_pow10(p1, pow10);
+
+				while (n > 0) {
+					const uint32_t d = p1 / pow10;
+					p1 %= pow10;
+					buffer[length++] = static_cast<char>('0' + d);
+					n--;
+
+					const uint64_t rest = (uint64_t{ p1 } << -one.e) + p2;
+					if (rest <= delta) {
+						decimal_exponent += n;
+						grisu2_round(buffer, length, dist, delta, rest, uint64_t{ pow10 } << -one.e);
+						return;
+					}
+					pow10 /= 10;
+				}
+
+				int m = 0;
+				for (;;) {
+					p2 *= 10;
+					const uint64_t d = p2 >> -one.e;
+					p2 &= one.f - 1;
+					buffer[length++] = static_cast<char>('0' + d);
+					m++;
+
+					delta *= 10;
+					dist *= 10;
+					if (p2 <= delta)
+						break;
+				}
+
+				decimal_exponent -= m;
+				grisu2_round(buffer, length, dist, delta, p2, one.f);
+			}
+
+			// writes the digits of value into buf, value = buf * 10^decimal_exponent
+			template<typename T>
+			void grisu2(char* buf, int& len, int& decimal_exponent, T value) {
+				const boundaries b = compute_boundaries(value);
+				const cached_power cached = get_cached_power_for_binary_exponent(b.plus.e);
+				const diyfp c_minus_k{ cached.f, cached.e };
+
+				const diyfp w = diyfp::mul(b.w, c_minus_k);
+				const diyfp w_minus = diyfp::mul(b.minus, c_minus_k);
+				const diyfp w_plus = diyfp::mul(b.plus, c_minus_k);
+
+				// shrink the interval by one ulp on each side to stay on the safe side
+				const diyfp m_minus{ w_minus.f + 1, w_minus.e };
+				const diyfp m_plus{ w_plus.f - 1, w_plus.e };
+
+				len = 0;
+				decimal_exponent = -cached.k;
+				grisu2_digit_gen(buf, len, decimal_exponent, m_minus, w, m_plus);
+			}
+
+			inline char* append_exponent(char* p, int e) {
+				if (e < 0) {
+					e = -e;
+					*p++ = '-';
+				}
+				else {
+					*p++ = '+';
+				}
+				return itoa_fwd(static_cast<uint32_t>(e), p);
+			}
+
+			// digits in buf[0, k), value = 0.buf * 10^n
+			inline char* format_shortest(char* buf, int k, int n) {
+				constexpr int min_exp = -6;
+				constexpr int max_exp = 21;
+
+				if (k <= n && n <= max_exp) {
+					// digits[000].0
+					std::memset(buf + k, '0', n - k);
+					buf[n] = '.';
+					buf[n + 1] = '0';
+					return buf + n + 2;
+				}
+
+				if (0 < n && n <= max_exp) {
+					// dig.its
+					std::memmove(buf + n + 1, buf + n, k - n);
+					buf[n] = '.';
+					return buf + k + 1;
+				}
+
+				if (min_exp < n && n <= 0) {
+					// 0.[000]digits
+					std::memmove(buf + 2 - n, buf, k);
+					buf[0] = '0';
+					buf[1] = '.';
+					std::memset(buf + 2, '0', -n);
+					return buf + 2 - n + k;
+				}
+
+				if (k == 1) {
+					// de+123
+					buf += 1;
+				}
+				else {
+					// d.igitse+123
+					std::memmove(buf + 2, buf + 1, k - 1);
+					buf[1] = '.';
+					buf += 1 + k;
+				}
+
+				*buf++ = 'e';
+				return append_exponent(buf, n - 1);
+			}
+
+			// rounds the digits in buf[0, k), value = 0.buf * 10^n, half up to
+			// precision fractional digits and writes them in positional notation
+			inline char* format_fixed(char* p, char* buf, int k, int n, int precision) {
+				const int keep = n + precision;
+				if (keep < k) {
+					if (keep < 0 || (keep == 0 && buf[0] < '5')) {
+						buf[0] = '0';
+						k = 1;
+						n = 1;
+					}
+					else if (keep == 0) {
+						buf[0] = '1';
+						k = 1;
+						n += 1;
+					}
+					else {
+						const bool round_up = buf[keep] >= '5';
+						k = keep;
+						if (round_up) {
+							int i = k - 1;
+							while (i >= 0 && buf[i] == '9') {
+								buf[i] = '0';
+								--i;
+							}
+							if (i < 0) {
+								buf[0] = '1';
+								k = 1;
+								n += 1;
+							}
+							else {
+								++buf[i];
+							}
+						}
+					}
+				}
+
+				if (n <= 0) {
+					*p++ = '0';
+				}
+				else {
+					const int int_digits = n < k ? n : k;
+					std::memcpy(p, buf, int_digits);
+					p += int_digits;
+					std::memset(p, '0', n - int_digits);
+					p += n - int_digits;
+				}
+
+				if (precision > 0) {
+					*p++ = '.';
+					for (int i = n; i < n + precision; ++i)
+						*p++ = (i >= 0 && i < k) ? buf[i] : '0';
+				}
+				return p;
+			}
+
+			template<typename T>
+			bool write_special(T value, char*& p) {
+				if (value != value) {
+					std::memcpy(p, "nan", 3);
+					p += 3;
+					return true;
+				}
+
+				std::memcpy(p, "-", 1);
+				p += std::signbit(value);
+
+				if (value == std::numeric_limits<T>::infinity() || value == -std::numeric_limits<T>::infinity()) {
+					std::memcpy(p, "inf", 3);
+					p += 3;
+					return true;
+				}
+				return false;
+			}
+		}
+	}
+
+	// enough for the shortest form of any float or double
+	constexpr std::size_t dtoa_buffer_size = 32;
+
+	// enough for the fixed form of any double with the given precision
+	constexpr std::size_t dtoa_fixed_buffer_size(int precision) {
+		return 1 + std::numeric_limits<double>::max_exponent10 + 2 + precision + 1;
+	}
+
+	// Writes the shortest text that reads back to value, returns the end.
+	// Positional notation is used for decimal exponents in [-6, 21),
+	// scientific otherwise (1e+21, 1.5e-7), like JavaScript's Number.toString.
+	// Integral values keep a ".0" so they still read as floating point.
+	template<typename T, typename = std::enable_if_t<std::is_floating_point<T>::value>>
+	char* dtoa_fwd(T value, char* p) {
+		using float_type = std::conditional_t<std::numeric_limits<T>::digits == 24, float, double>;
+
+		if (detail::dtoa::write_special(value, p))
+			return p;
+
+		if (value == 0) {
+			std::memcpy(p, "0.0", 3);
+			return p + 3;
+		}
+
+		int len, decimal_exponent;
+		detail::dtoa::grisu2(p, len, decimal_exponent, static_cast<float_type>(std::abs(value)));
+		return detail::dtoa::format_shortest(p, len, len + decimal_exponent);
+	}
+
+	// Writes value with exactly precision fractional digits, rounding the
+	// shortest round-trip digits half up; the locale independent "%.*f".
+	// The json and xml writers use it when IGUANA_FLOAT_PRECISION is defined.
+	template<typename T, typename = std::enable_if_t<std::is_floating_point<T>::value>>
+	char* dtoa_fixed(T value, int precision, char* p) {
+		using float_type = std::conditional_t<std::numeric_limits<T>::digits == 24, float, double>;
+
+		if (detail::dtoa::write_special(value, p))
+			return p;
+
+		char digits[32];
+		int len = 1, decimal_exponent = 0;
+		digits[0] = '0';
+		if (value != 0)
+			detail::dtoa::grisu2(digits, len, decimal_exponent, static_cast<float_type>(std::abs(value)));
+		return detail::dtoa::format_fixed(p, digits, len, len + decimal_exponent, precision < 0 ? 0 : precision);
+	}
+}
+
+#endif //SERIALIZE_DTOA_HPP
@@ -0,0 +1,111 @@
+//
+// error reporting for the non-throwing from_json/from_xml
+//
+
+#ifndef SERIALIZE_ERROR_HPP
+#define SERIALIZE_ERROR_HPP
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || (defined(_MSC_VER) && defined(_CPPUNWIND))
+#define IGUANA_HAS_EXCEPTIONS
+#endif
+
+namespace iguana {
+	enum class errc : uint8_t {
+		ok,
+		unexpected_end,		//the input stopped in the middle of a value
+		invalid_document,
+		expected_object,
+		expected_array,
+		invalid_object,
+		invalid_array,
+		invalid_string,
+		invalid_escape,
+		invalid_number,
+		invalid_comment,
+		type_mismatch,		//a valid value of the wrong type for the member
+		out_of_range,
+		needs_arena,		//an escaped string read into a view without an arena
+	};
+
+	inline const char * error_message(errc code)
+	{
+		switch (code)
+		{
+		case errc::ok: return "ok";
+		case errc::unexpected_end: return "unexpected end of input";
+		case errc::invalid_document: return "invalid document";
+		case errc::expected_object: return "object expected";
+		case errc::expected_array: return "array expected";
+		case errc::invalid_object: return "invalid object";
+		case errc::invalid_array: return "invalid array";
+		case errc::invalid_string: return "invalid string";
+		case errc::invalid_escape: return "invalid escape sequence";
+		case errc::invalid_number: return "invalid number";
+		case errc::invalid_comment: return "invalid comment";
+		case errc::type_mismatch: return "value does not match the member type";
+		case errc::out_of_range: return "value out of range for the member type";
+		case errc::needs_arena: return "escaped string needs an arena";
+		}
+		return "unknown error";
+	}
+
+	//what the non-throwing readers return; converts to true when reading failed
+	struct parse_error
+	{
+		errc code = errc::ok;
+		//into the input, where reading stopped
+		std::size_t offset = 0;
+		//json pointer to the member being read, e.g. /items/3/name; empty for the root
+		std::string path;
+
+		explicit operator bool() const
+		{
+			return code != errc::ok;
+		}
+
+		const char * message() const
+		{
+			return error_message(code);
+		}
+	};
+
+	namespace detail {
+		//builds with -fno-exceptions too, failing like the standard library does there
+		[[noreturn]] inline void throw_invalid_argument(const std::string& message)
+		{
+#ifdef IGUANA_HAS_EXCEPTIONS
+			throw std::invalid_argument(message);
+#else
+			(void)message;
+			abort();
+#endif
+		}
+
+		//prepends /name to a json pointer, escaping '~' and '/'
+		inline void push_path(std::string& path, const char * name, std::size_t len)
+		{
+			std::string segment(1, '/');
+			for (std::size_t i = 0; i < len; ++i)
+			{
+				if (name[i] == '~')
+					segment += "~0";
+				else if (name[i] == '/')
+					segment += "~1";
+				else
+					segment += name[i];
+			}
+			path.insert(0, segment);
+		}
+
+		inline void push_path(std::string& path, std::size_t index)
+		{
+			path.insert(0, "/" + std::to_string(index));
+		}
+	}
+}
+#endif //SERIALIZE_ERROR_HPP
@@ -1,6 +1,8 @@
+#include <cassert>
 #include <iostream>
 #include "json.hpp"
 #include "xml.hpp"
+#include "sink_stream.hpp"
 
 struct person
 {
@@ -35,6 +37,13 @@ struct composit_t
 };
 REFLECTION(composit_t, a, b, c, d, e, f, g);
 
+struct roster_t
+{
+	std::map<std::string, person> m;
+	std::vector<person> v;
+};
+REFLECTION(roster_t, m, v);
+
 void test_json()
 {
 	person p;
@@ -51,11 +60,83 @@ void test_json()
 	iguana::json::to_json(sst, composit);
 	std::cout << sst.str() << std::endl;
 
-	const char* str_comp = R"({"a":1, "b":["tom", "jack"], "c":3, "d":{"2":3,"5":6},"e":{"3":4},"f":5.3,"g":[{"id":1},{"id":2}])";
+	const char* str_comp = R"({"a":1, "b":["tom", "jack"], "c":3, "d":{"2":3,"5":6},"e":{"3":4},"f":5.3,"g":[{"id":1},{"id":2}]})";
 	composit_t comp;
 	iguana::json::from_json(comp, str_comp);
 }
 
+void test_json_reuse()
+{
+	const char* first = R"({"m":{"alice":{"name":"secret","age":1}},"v":[{"name":"tok","age":5}]})";
+	const char* second = R"({"m":{"bob":{"age":2}},"v":[{"age":6}]})";
+	roster_t r;
+	iguana::json::from_json_reuse(r, first);
+	iguana::json::from_json_reuse(r, second);
+
+	roster_t fresh;
+	iguana::json::from_json(fresh, second);
+	iguana::string_stream reused_ss, fresh_ss;
+	iguana::json::to_json(reused_ss, r);
+	iguana::json::to_json(fresh_ss, fresh);
+	assert(reused_ss.str() == fresh_ss.str());
+	assert(r.m["bob"].name.empty() && r.v[0].name.empty());
+}
+
+void test_lazy_view()
+{
+	const char* json = R"({"name":tom,"age":x1,"name":"jack"})";
+	person eager;
+	iguana::json::from_json(eager, json);
+	auto v = iguana::json::lazy_from_json<person>(json);
+	assert(v.get<0>() == eager.name && v.get<1>() == eager.age);
+
+	//values of unknown members are checked as from_json skips them
+	bool thrown = false;
+	try {
+		iguana::json::lazy_from_json<person>(R"({"x":{"a"},"age":1})");
+	}
+	catch (std::invalid_argument&) {
+		thrown = true;
+	}
+	assert(thrown);
+}
+
+void test_arena_move()
+{
+	iguana::arena a(64);
+	const char* s = a.copy("tom", 3);
+	iguana::arena b(std::move(a));
+	assert(b.size() == 3 && a.size() == 0);
+
+	//the moved from arena starts over with blocks of its own
+	const char* t = a.copy("jack", 4);
+	assert(std::string(s, 3) == "tom" && std::string(t, 4) == "jack");
+
+	iguana::arena c;
+	c.copy("x", 1);
+	c = std::move(b);
+	assert(c.size() == 3 && b.size() == 0);
+	b.copy("y", 1);
+	assert(std::string(s, 3) == "tom");
+}
+
+void test_sink_stream()
+{
+	two t = { "test",{ 2 }, 4 };
+	iguana::string_stream ss;
+	iguana::json::to_json(ss, t);
+
+	std::string out;
+	{
+		iguana::sink_stream s([&out](const char * data, std::size_t len) {
+			out.append(data, len);
+			return true;
+		}, 0);
+		iguana::json::to_json(s, t);
+	}
+	assert(out == ss.str());
+}
+
 //void performance()
 //{
 //	person obj;
@@ -143,4 +224,8 @@ int main()
 	test_reflection();
 //	test_json();
 	test_xml();
+	test_json_reuse();
+	test_lazy_view();
+	test_arena_move();
+	test_sink_stream();
 }
\ No newline at end of file
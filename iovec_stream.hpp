@@ -0,0 +1,180 @@
+//
+// scatter-gather output for to_json/to_xml, posix only
+//
+
+#ifndef SERIALIZE_IOVEC_STREAM_HPP
+#define SERIALIZE_IOVEC_STREAM_HPP
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <string>
+#include <vector>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+namespace iguana {
+	//small pieces are copied into a scratch buffer, string bodies of at least
+	//ref_threshold bytes are referenced in place; the serialized object must
+	//outlive the stream until the iovecs have been written
+	class iovec_stream
+	{
+		//ref == nullptr means offset is into m_scratch, which may still move
+		struct segment
+		{
+			const char * ref;
+			std::size_t offset;
+			std::size_t len;
+		};
+
+	public:
+		explicit iovec_stream(std::size_t ref_threshold = 256) : m_ref_threshold(ref_threshold), m_size(0)
+		{
+		}
+
+		inline std::size_t write(const char * buffer)
+		{
+			return write(buffer, strlen(buffer));
+		}
+
+		inline std::size_t write(const char * buffer, std::size_t len)
+		{
+			if (len == 0)
+				return 0;
+			if (this->m_segments.empty() || this->m_segments.back().ref != nullptr)
+				this->m_segments.push_back(segment{ nullptr, this->m_scratch.size(), 0 });
+			this->m_scratch.append(buffer, len);
+			this->m_segments.back().len += len;
+			this->m_size += len;
+			return len;
+		}
+
+		inline void put(char c)
+		{
+			if (this->m_segments.empty() || this->m_segments.back().ref != nullptr)
+				this->m_segments.push_back(segment{ nullptr, this->m_scratch.size(), 0 });
+			this->m_scratch.push_back(c);
+			++this->m_segments.back().len;
+			++this->m_size;
+		}
+
+		inline std::size_t write_ref(const char * buffer, std::size_t len)
+		{
+			if (len < this->m_ref_threshold)
+				return write(buffer, len);
+			this->m_segments.push_back(segment{ buffer, 0, len });
+			this->m_size += len;
+			return len;
+		}
+
+		//total bytes written, copied or referenced
+		inline std::size_t size() const
+		{
+			return this->m_size;
+		}
+
+		inline std::size_t copied_size() const
+		{
+			return this->m_scratch.size();
+		}
+
+		inline void clear()
+		{
+			this->m_scratch.clear();
+			this->m_segments.clear();
+			this->m_iov.clear();
+			this->m_size = 0;
+		}
+
+		//valid until the next write or clear
+		const std::vector<struct iovec>& iov()
+		{
+			this->m_iov.resize(this->m_segments.size());
+			for (std::size_t i = 0; i < this->m_segments.size(); ++i)
+			{
+				const segment& seg = this->m_segments[i];
+				const char * base = seg.ref != nullptr ? seg.ref : this->m_scratch.data() + seg.offset;
+				this->m_iov[i].iov_base = const_cast<char*>(base);
+				this->m_iov[i].iov_len = seg.len;
+			}
+			return this->m_iov;
+		}
+
+		std::string str() const
+		{
+			std::string s;
+			s.reserve(this->m_size);
+			for (const segment& seg : this->m_segments)
+				s.append(seg.ref != nullptr ? seg.ref : this->m_scratch.data() + seg.offset, seg.len);
+			return s;
+		}
+
+		//writes everything, returns the byte count or -1 with errno set
+		ssize_t writev(int fd)
+		{
+			return this->write_all([fd](const struct iovec * v, int n)
+			{
+				return ::writev(fd, v, n);
+			});
+		}
+
+		ssize_t sendmsg(int fd, int flags = 0)
+		{
+			return this->write_all([fd, flags](const struct iovec * v, int n)
+			{
+				struct msghdr msg;
+				memset(&msg, 0, sizeof(msg));
+				msg.msg_iov = const_cast<struct iovec*>(v);
+				msg.msg_iovlen = n;
+				return ::sendmsg(fd, &msg, flags);
+			});
+		}
+
+	private:
+		//retries short writes and EINTR, at most IOV_MAX entries per call
+		template<typename F>
+		ssize_t write_all(F f)
+		{
+			this->iov();
+			struct iovec * v = this->m_iov.data();
+			struct iovec * end = v + this->m_iov.size();
+			ssize_t total = 0;
+			while (v != end)
+			{
+				int n = end - v > IOV_MAX ? IOV_MAX : static_cast<int>(end - v);
+				ssize_t written = f(v, n);
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return -1;
+				}
+				total += written;
+				std::size_t left = static_cast<std::size_t>(written);
+				while (v != end && left >= v->iov_len)
+				{
+					left -= v->iov_len;
+					++v;
+				}
+				if (left != 0)
+				{
+					v->iov_base = static_cast<char*>(v->iov_base) + left;
+					v->iov_len -= left;
+				}
+			}
+			return total;
+		}
+
+		std::size_t m_ref_threshold;
+		std::size_t m_size;
+		std::string m_scratch;
+		std::vector<segment> m_segments;
+		std::vector<struct iovec> m_iov;
+	};
+}
+#endif //SERIALIZE_IOVEC_STREAM_HPP
@@ -5,13 +5,116 @@
 #ifndef SERIALIZE_JSON_HPP
 #define SERIALIZE_JSON_HPP
 #include <string.h>
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <thread>
 #include "reflection.hpp"
 #include "traits.hpp"
 #include "itoa.hpp"
+#include "dtoa.hpp"
+#include "atod.hpp"
+#include "arena.hpp"
+#include "error.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IGUANA_USE_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IGUANA_USE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace iguana {
+	//memory detached from a basic_string_stream by release(), freed on destruction
 	template <typename alloc_ty>
-	struct basic_string_stream
+	class basic_stream_buffer
+	{
+	public:
+		basic_stream_buffer() : m_data(nullptr), m_size(0), m_capacity(0)
+		{
+		}
+
+		basic_stream_buffer(const alloc_ty& alloc, char * data, std::size_t size, std::size_t capacity)
+			: m_alloc(alloc), m_data(data), m_size(size), m_capacity(capacity)
+		{
+		}
+
+		basic_stream_buffer(basic_stream_buffer&& other)
+			: m_alloc(std::move(other.m_alloc)), m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity)
+		{
+			other.m_data = nullptr;
+			other.m_size = 0;
+			other.m_capacity = 0;
+		}
+
+		basic_stream_buffer& operator=(basic_stream_buffer&& other)
+		{
+			basic_stream_buffer temp(std::move(other));
+			this->swap(temp);
+			return *this;
+		}
+
+		~basic_stream_buffer()
+		{
+			if (this->m_data != nullptr)
+				this->m_alloc.deallocate(this->m_data, this->m_capacity);
+		}
+
+		void swap(basic_stream_buffer& other)
+		{
+			using std::swap;
+			swap(this->m_alloc, other.m_alloc);
+			swap(this->m_data, other.m_data);
+			swap(this->m_size, other.m_size);
+			swap(this->m_capacity, other.m_capacity);
+		}
+
+		inline char * data() const { return this->m_data; }
+		inline std::size_t size() const { return this->m_size; }
+		inline std::size_t capacity() const { return this->m_capacity; }
+		inline bool empty() const { return this->m_size == 0; }
+		inline char * begin() const { return this->m_data; }
+		inline char * end() const { return this->m_data + this->m_size; }
+
+	private:
+		alloc_ty m_alloc;
+		char * m_data;
+		std::size_t m_size;
+		std::size_t m_capacity;
+	};
+
+	namespace detail {
+		//storage a stream uses before it spills to the allocator
+		template <std::size_t N>
+		struct inline_buffer
+		{
+			char m_inline[N];
+
+			inline char * inline_data() { return this->m_inline; }
+			inline const char * inline_data() const { return this->m_inline; }
+		};
+
+		template <>
+		struct inline_buffer<0>
+		{
+			inline char * inline_data() { return nullptr; }
+			inline const char * inline_data() const { return nullptr; }
+		};
+	}
+
+	//with inline_size > 0 the first inline_size bytes live inside the stream
+	//itself and nothing is allocated until a message outgrows them
+	template <typename alloc_ty, std::size_t inline_size = 0>
+	struct basic_string_stream : private detail::inline_buffer<inline_size>
 	{
 	private:
 		alloc_ty alloc;
@@ -26,17 +129,41 @@ namespace iguana {
 		std::size_t			m_length;
 
 		enum { INIT_BUFF_SIZE = 1024 };
-		basic_string_stream() :m_length(INIT_BUFF_SIZE), m_status(good)
+		basic_string_stream() :m_status(good), m_length(inline_size == 0 ? static_cast<std::size_t>(INIT_BUFF_SIZE) : inline_size)
 		{
-			this->m_header_ptr = this->alloc.allocate(INIT_BUFF_SIZE);
+			this->m_header_ptr = inline_size == 0 ? this->alloc.allocate(INIT_BUFF_SIZE) : this->inline_data();
 			this->m_read_ptr = this->m_header_ptr;
 			this->m_write_ptr = this->m_header_ptr;
 			this->m_tail_ptr = this->m_header_ptr + m_length;
 		}
 
+		basic_string_stream(basic_string_stream&& other)
+			: alloc(std::move(other.alloc))
+		{
+			this->take(other);
+		}
+
+		basic_string_stream& operator=(basic_string_stream&& other)
+		{
+			if (this != &other)
+			{
+				this->deallocate();
+				this->alloc = std::move(other.alloc);
+				this->take(other);
+			}
+			return *this;
+		}
+
 		~basic_string_stream()
 		{
-			this->alloc.deallocate(m_header_ptr, this->m_length);
+			this->deallocate();
+		}
+
+		void swap(basic_string_stream& other)
+		{
+			basic_string_stream temp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(temp);
 		}
 
 		inline std::size_t write(const char * buffer)
@@ -56,15 +183,23 @@ namespace iguana {
 			return len;
 		}
 
+		//grows at least geometrically so appending n bytes costs amortized O(n)
 		inline std::size_t growpup(std::size_t want_size)
 		{
-			std::size_t new_size = ((want_size + INIT_BUFF_SIZE - 1) / INIT_BUFF_SIZE)*INIT_BUFF_SIZE;
+			std::size_t new_size = this->m_length * 2;
+			if (new_size < want_size)
+				new_size = want_size;
+			new_size = ((new_size + INIT_BUFF_SIZE - 1) / INIT_BUFF_SIZE)*INIT_BUFF_SIZE;
 			std::size_t write_pos = this->m_write_ptr - this->m_header_ptr;
 			std::size_t read_pos = this->m_read_ptr - this->m_header_ptr;
 			char * temp = this->m_header_ptr;
 			this->m_header_ptr = this->alloc.allocate(new_size);
-			std::memcpy(this->m_header_ptr, temp, this->m_length);
-			this->alloc.deallocate(temp, this->m_length);
+			if (temp != nullptr)
+			{
+				std::memcpy(this->m_header_ptr, temp, write_pos);
+				if (temp != this->inline_data())
+					this->alloc.deallocate(temp, this->m_length);
+			}
 			this->m_length = new_size;
 			this->m_write_ptr = this->m_header_ptr + write_pos;
 			this->m_read_ptr = this->m_header_ptr + read_pos;
@@ -72,6 +207,19 @@ namespace iguana {
 			return new_size;
 		}
 
+		inline void reserve(std::size_t len)
+		{
+			if (len > this->m_length)
+			{
+				this->growpup(len);
+			}
+		}
+
+		inline std::size_t capacity() const
+		{
+			return this->m_length;
+		}
+
 		inline std::size_t write(const char * buffer, std::size_t len)
 		{
 			std::size_t writed_len = this->m_write_ptr + len - this->m_header_ptr;
@@ -114,6 +262,25 @@ namespace iguana {
 			return s;
 		}
 
+		//hands the written bytes over without copying, the stream is left empty
+		//and allocates again on the next write
+		basic_stream_buffer<alloc_ty> release()
+		{
+			if (this->is_inline())
+			{
+				//inline bytes cannot change owner, they are small enough to copy
+				std::size_t size = this->write_length();
+				char * data = this->alloc.allocate(size == 0 ? 1 : size);
+				std::memcpy(data, this->m_header_ptr, size);
+				this->clear();
+				return basic_stream_buffer<alloc_ty>(this->alloc, data, size, size == 0 ? 1 : size);
+			}
+
+			basic_stream_buffer<alloc_ty> buffer(this->alloc, this->m_header_ptr, this->write_length(), this->m_length);
+			this->reset();
+			return buffer;
+		}
+
 		inline ::std::size_t read_length() const
 		{
 			return this->m_read_ptr - this->m_header_ptr;
@@ -123,9 +290,110 @@ namespace iguana {
 		{
 			return this->m_write_ptr - this->m_header_ptr;
 		}
+
+		inline bool is_inline() const
+		{
+			return inline_size != 0 && this->m_header_ptr == this->inline_data();
+		}
+
+	private:
+		//back to the empty inline buffer, or to no buffer at all without one
+		inline void reset()
+		{
+			this->m_header_ptr = this->inline_data();
+			this->m_read_ptr = this->m_header_ptr;
+			this->m_write_ptr = this->m_header_ptr;
+			this->m_tail_ptr = this->m_header_ptr + inline_size;
+			this->m_status = good;
+			this->m_length = inline_size;
+		}
+
+		inline void deallocate()
+		{
+			if (this->m_header_ptr != nullptr && !this->is_inline())
+				this->alloc.deallocate(this->m_header_ptr, this->m_length);
+		}
+
+		//steals the buffer of other, inline bytes are copied into our own
+		inline void take(basic_string_stream& other)
+		{
+			std::size_t write_pos = other.write_length();
+			std::size_t read_pos = other.read_length();
+			if (other.is_inline())
+			{
+				this->m_header_ptr = this->inline_data();
+				this->m_length = inline_size;
+				std::memcpy(this->m_header_ptr, other.m_header_ptr, write_pos);
+			}
+			else
+			{
+				this->m_header_ptr = other.m_header_ptr;
+				this->m_length = other.m_length;
+			}
+			this->m_read_ptr = this->m_header_ptr + read_pos;
+			this->m_write_ptr = this->m_header_ptr + write_pos;
+			this->m_tail_ptr = this->m_header_ptr + this->m_length;
+			this->m_status = other.m_status;
+			other.reset();
+		}
 	};
 
+	template <typename alloc_ty, std::size_t inline_size>
+	inline void swap(basic_string_stream<alloc_ty, inline_size>& a, basic_string_stream<alloc_ty, inline_size>& b)
+	{
+		a.swap(b);
+	}
+
 	typedef basic_string_stream<std::allocator<char> > string_stream;
+	typedef basic_stream_buffer<std::allocator<char> > stream_buffer;
+
+	//keeps messages up to N bytes off the heap, e.g. small_string_stream<256>
+	template <std::size_t N>
+	using small_string_stream = basic_string_stream<std::allocator<char>, N>;
+
+	//writes through a raw pointer without any capacity check, the caller
+	//provides room for json::serialized_size bytes
+	struct unchecked_stream
+	{
+		char * m_write_ptr;
+
+		explicit unchecked_stream(char * buffer) : m_write_ptr(buffer)
+		{
+		}
+
+		inline std::size_t write(const char * buffer)
+		{
+			return write(buffer, strlen(buffer));
+		}
+
+		inline std::size_t write(const char * buffer, std::size_t len)
+		{
+			std::memcpy(this->m_write_ptr, buffer, len);
+			this->m_write_ptr += len;
+			return len;
+		}
+
+		inline void put(char c)
+		{
+			*this->m_write_ptr = c;
+			++this->m_write_ptr;
+		}
+	};
+
+	//streams whose buffer can be grown up front and then written in place
+	template<typename Stream, typename = void>
+	struct is_reservable_stream : std::false_type
+	{
+	};
+
+	template<typename Stream>
+	struct is_reservable_stream<Stream, void_t<
+		decltype(std::declval<Stream&>().reserve(std::size_t{})),
+		decltype(std::declval<Stream&>().write_length()),
+		decltype(std::declval<Stream&>().m_write_ptr)
+		>> : std::true_type
+	{
+	};
 
 	namespace json {
 		template<typename InputIt, typename T, typename F>
@@ -140,6 +408,9 @@ namespace iguana {
 
 		template<typename Stream, typename InputIt, typename T, typename F>
 		void join(Stream& ss, InputIt first, InputIt last, const T &delim, const F &f) {
+			if (first == last)
+				return;
+
 			f(*first++);
 			while (first != last) {
 				ss.put(delim);
@@ -165,16 +436,146 @@ namespace iguana {
 		template<typename Stream, typename T>
 		std::enable_if_t<std::is_floating_point<T>::value> render_json_value(Stream& ss, T value)
 		{
-			char temp[20];
-			sprintf(temp, "%f", value);
-			ss.write(temp);
+			//json has no nan or inf
+			if (!std::isfinite(value))
+			{
+				ss.write("null", 4);
+				return;
+			}
+
+#ifdef IGUANA_FLOAT_PRECISION
+			char temp[dtoa_fixed_buffer_size(IGUANA_FLOAT_PRECISION)];
+			auto p = dtoa_fixed(value, IGUANA_FLOAT_PRECISION, temp);
+#else
+			char temp[dtoa_buffer_size];
+			auto p = dtoa_fwd(value, temp);
+#endif
+			ss.write(temp, p - temp);
 		}
 
-		template<typename Stream>
-		void render_json_value(Stream& ss, const std::string &s)
+		namespace detail {
+			inline unsigned count_trailing_zeros(uint32_t mask) {
+#if defined(_MSC_VER)
+				unsigned long index;
+				_BitScanForward(&index, mask);
+				return index;
+#else
+				return __builtin_ctz(mask);
+#endif
+			}
+
+			//'"', '\\' and control characters must be escaped in json strings
+			inline bool needs_escape(char c) {
+				return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+			}
+
+			//the first byte in [p, end) that needs escaping, or end; the common
+			//clean case is tested 32 or 16 bytes at a time
+			inline const char* find_escape(const char* p, const char* end) {
+#ifdef IGUANA_USE_AVX2
+				const __m256i quote32 = _mm256_set1_epi8('"');
+				const __m256i backslash32 = _mm256_set1_epi8('\\');
+				const __m256i ctrl32 = _mm256_set1_epi8(0x1F);
+				for (; end - p >= 32; p += 32) {
+					const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					const __m256i m = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, backslash32)),
+						_mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl32), v));
+					const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(m));
+					if (mask != 0)
+						return p + count_trailing_zeros(mask);
+				}
+#endif
+#ifdef IGUANA_USE_SSE2
+				const __m128i quote = _mm_set1_epi8('"');
+				const __m128i backslash = _mm_set1_epi8('\\');
+				const __m128i ctrl = _mm_set1_epi8(0x1F);
+				for (; end - p >= 16; p += 16) {
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+					const __m128i m = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+						_mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+					const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(m));
+					if (mask != 0)
+						return p + count_trailing_zeros(mask);
+				}
+#endif
+				for (; p < end; ++p) {
+					if (needs_escape(*p))
+						return p;
+				}
+				return end;
+			}
+
+			//length of the escape sequence written for c
+			inline size_t escape_size(char c) {
+				switch (c) {
+				case '"': case '\\': case '\b': case '\f': case '\n': case '\r': case '\t':
+					return 2;
+				default:
+					return 6;
+				}
+			}
+
+			template<typename Stream>
+			void write_escape(Stream& ss, char c) {
+				static const char hex[] = "0123456789abcdef";
+				char buf[6] = { '\\', 0, '0', '0', 0, 0 };
+				switch (c) {
+				case '"': buf[1] = '"'; break;
+				case '\\': buf[1] = '\\'; break;
+				case '\b': buf[1] = 'b'; break;
+				case '\f': buf[1] = 'f'; break;
+				case '\n': buf[1] = 'n'; break;
+				case '\r': buf[1] = 'r'; break;
+				case '\t': buf[1] = 't'; break;
+				default:
+					buf[1] = 'u';
+					buf[4] = hex[(c >> 4) & 0xF];
+					buf[5] = hex[c & 0xF];
+					ss.write(buf, 6);
+					return;
+				}
+				ss.write(buf, 2);
+			}
+
+			//size of s once escaped, without the quotes
+			inline size_t escaped_size(const char* s, size_t size) {
+				const char* end = s + size;
+				for (const char* p = find_escape(s, end); p != end; p = find_escape(p + 1, end))
+					size += escape_size(*p) - 1;
+				return size;
+			}
+
+			//copies clean runs in bulk and escapes the bytes between them
+			template<typename Stream>
+			void write_escaped(Stream& ss, const char* s, size_t size) {
+				const char* end = s + size;
+				for (;;) {
+					const char* p = find_escape(s, end);
+					if (p != s)
+						write_stable(ss, s, p - s);
+					if (p == end)
+						return;
+					write_escape(ss, *p);
+					s = p + 1;
+				}
+			}
+		}
+
+		template<typename Stream, typename T>
+		std::enable_if_t<is_char_string<T>::value> render_json_value(Stream& ss, const T &s)
+		{
+			ss.put('"');
+			detail::write_escaped(ss, s.data(), s.size());
+			ss.put('"');
+		}
+
+		template<typename Stream, typename T>
+		std::enable_if_t<is_string_view<T>::value> render_json_value(Stream& ss, const T &s)
 		{
 			ss.put('"');
-			ss.write(s.c_str(), s.size());
+			detail::write_escaped(ss, s.data(), s.size());
 			ss.put('"');
 		}
 
@@ -182,7 +583,7 @@ namespace iguana {
 		void render_json_value(Stream& ss, const char* s, size_t size)
 		{
 			ss.put('"');
-			ss.write(s, size);
+			detail::write_escaped(ss, s, size);
 			ss.put('"');
 		}
 
@@ -193,17 +594,17 @@ namespace iguana {
 			ss.put('"');
 		}
 
-		template<typename Stream>
-		void render_key(Stream& ss, const std::string &s) {
+		template<typename Stream, typename T>
+		std::enable_if_t<is_char_string<T>::value> render_key(Stream& ss, const T &s) {
 			render_json_value(ss, s);
 		}
 
 		template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-		void to_json(Stream& ss, T &&t);
+		void to_json_impl(Stream& ss, T &&t);
 
 		template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
 		void render_json_value(Stream& ss, T &&t) {
-			to_json(ss, std::forward<T>(t));
+			to_json_impl(ss, std::forward<T>(t));
 		}
 
 		template<typename Stream, typename T>
@@ -223,6 +624,15 @@ namespace iguana {
 			ss.put(']');
 		}
 
+		//declared ahead so containers of containers find each other
+		template<typename Stream, typename T>
+		std::enable_if_t <is_associat_container<T>::value>
+			render_json_value(Stream& ss, const T&o);
+
+		template<typename Stream, typename T>
+		std::enable_if_t <is_sequence_container<T>::value || is_set_container<T>::value>
+			render_json_value(Stream& ss, const T &v);
+
 		template<typename Stream, typename T>
 		std::enable_if_t <is_associat_container<T>::value>
 			render_json_value(Stream& ss, const T&o) {
@@ -237,7 +647,8 @@ namespace iguana {
 		}
 
 		template<typename Stream, typename T>
-		std::enable_if_t <is_sequence_container<T>::value> render_json_value(Stream& ss, const T &v) {
+		std::enable_if_t <is_sequence_container<T>::value || is_set_container<T>::value>
+			render_json_value(Stream& ss, const T &v) {
 			ss.put('[');
 			join(ss, v.cbegin(), v.cend(), ',',
 				[&ss](const auto &jsv) {
@@ -245,131 +656,900 @@ namespace iguana {
 			});
 			ss.put(']');
 		}
-		//template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-		//void write_json_key(Stream& s, size_t I)
-		//{
-		//	s.put('"');
-		//	auto name = get_name<T>(I);
-		//	s.write(name, strlen(name));
-		//	s.put('"');
-		//}
-
-#define write_json_key(s, I)\
-		s.put('"');\
-		auto name = get_name<T>(I);\
-		s.write(name, strlen(name));\
-		s.put('"');
-
-		template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-		void to_json(Stream& s, T &&t) {
-			s.put('{');
-			for_each(std::forward<T>(t),
-				[&s](const auto &v, size_t I, bool is_last) { //magic for_each struct std::forward<T>(t)
-				write_json_key(s, I);
-				s.put(':');
-				render_json_value(s, v);
-				if (!is_last)
-					s.put(',');
-			}, [&s](const auto &o, size_t I, bool is_last) {
-				write_json_key(s, I);
-				s.put(':');
-				to_json(s, o);
-				if (!is_last)
-					s.put(',');
-			});
-			s.put('}');
+		template<typename T, typename Stream, size_t I>
+		inline void write_json_key(Stream& s, std::integral_constant<size_t, I>)
+		{
+			using M = Members<std::remove_const_t<std::remove_reference_t<T>>>;
+			constexpr name_fragment key = M::json_keys[I];
+			s.write(key.data, key.size);
+		}
 
-			//return s.str();
+		///*********************************** serialized size *********************************///
+		//the number of bytes to_json writes for a value, exact except for floating point
+		//values which count as their longest possible form
+		inline size_t count_digits(uint64_t v) {
+			size_t n = 1;
+			for (;;) {
+				if (v < 10) return n;
+				if (v < 100) return n + 1;
+				if (v < 1000) return n + 2;
+				if (v < 10000) return n + 3;
+				v /= 10000;
+				n += 4;
+			}
 		}
 
-		template<typename Stream, typename T>
-		void to_json(Stream& s, const std::vector<T> &v) {
-			render_json_value(v);
-		};
+		inline size_t json_value_size(nullptr_t) { return 4; }
 
-		template<typename Stream, typename... Args>
-		void to_json(Stream& s, std::tuple<Args...> tp) {
-			s.put('[');
-			apply_tuple([&s](const auto &v, size_t I, bool is_last) {
-				render_json_value(s, v);
-				if (!is_last)
-					s.put(',');
-			}, tp, std::make_index_sequence<sizeof...(Args)>{});
-			s.put(']');
+		inline size_t json_value_size(bool b) { return b ? 4 : 5; }
+
+		template<typename T>
+		std::enable_if_t<!std::is_floating_point<T>::value&&std::is_unsigned<T>::value, size_t> json_value_size(T value)
+		{
+			return count_digits(value);
 		}
 
-		///***********************************  from json*********************************///
-		//reader from ajson
-		namespace detail {
-			struct string_ref {
-				char const *str;
-				size_t len;
+		template<typename T>
+		std::enable_if_t<!std::is_floating_point<T>::value&&std::is_signed<T>::value, size_t> json_value_size(T value)
+		{
+			return value < 0 ? 1 + count_digits(0 - static_cast<uint64_t>(value)) : count_digits(static_cast<uint64_t>(value));
+		}
 
-				int length() const {
-					int size = len;
-					for (size_t i = 0; i < len; ++i) {
-						if (str[i] == 92 || str[i] == 116 || str[i] == 50)
-							size -= 1;
-					}
+#ifdef IGUANA_FLOAT_PRECISION
+		constexpr size_t float_json_size = dtoa_fixed_buffer_size(IGUANA_FLOAT_PRECISION);
+#else
+		constexpr size_t float_json_size = dtoa_buffer_size;
+#endif
 
-					return size;
-				}
+		template<typename T>
+		std::enable_if_t<std::is_floating_point<T>::value, size_t> json_value_size(T)
+		{
+			return float_json_size;
+		}
 
-				bool operator!=(const char *data) const {
-					const int str_length = strlen(data);
-					if (len != str_length) {
-						if (length() != str_length)
-							return true;
-					}
+		template<typename T>
+		std::enable_if_t<is_char_string<T>::value, size_t> json_value_size(const T &s)
+		{
+			return detail::escaped_size(s.data(), s.size()) + 2;
+		}
 
-					for (int i = 0; i < str_length; ++i) {
-						if (str[i] != data[i]) {
-							return true;
-						}
-					}
-					return false;
-				}
-			};
+		template<typename T>
+		std::enable_if_t<is_string_view<T>::value, size_t> json_value_size(const T &s)
+		{
+			return detail::escaped_size(s.data(), s.size()) + 2;
 		}
-		struct token {
-			detail::string_ref str;
-			enum {
-				t_string,
-				t_int,
-				t_uint,
-				t_number,
-				t_ctrl,
-				t_end,
-			} type;
-			union {
-				int64_t i64;
-				uint64_t u64;
-				double d64;
-			} value;
-		};
 
-		class reader_t {
-		public:
-			reader_t(const char *ptr = nullptr, size_t len = -1) : ptr_(ptr), len_(len) {
-				if (ptr == nullptr) {
-					end_mark_ = true;
-				}
-				else if (len == 0) {
-					end_mark_ = true;
-				}
-				else if (ptr[0] == 0) {
-					end_mark_ = true;
-				}
-				next();
-			}
+		template<typename T>
+		std::enable_if_t<std::is_arithmetic<T>::value, size_t> json_key_size(T t) {
+			return json_value_size(t) + 2;
+		}
 
-			static inline char *itoa_native(size_t val, char *buffer, size_t len) {
-				buffer[len] = 0;
-				size_t pos = len - 1;
-				if (val == 0) {
-					buffer[pos--] = '0';
-				}
-				while (val) {
+		template<typename T>
+		std::enable_if_t<is_char_string<T>::value, size_t> json_key_size(const T &s) {
+			return json_value_size(s);
+		}
+
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		size_t serialized_size(const T &t);
+
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		size_t json_value_size(const T &t) {
+			return serialized_size(t);
+		}
+
+		template<typename T>
+		std::enable_if_t<std::is_enum<T>::value, size_t> json_value_size(T val)
+		{
+			return json_value_size((std::underlying_type_t<T>&)val);
+		}
+
+		template <typename T, size_t N>
+		size_t json_value_size(const T(&v)[N])
+		{
+			size_t size = 1 + N;
+			for (auto &item : v)
+				size += json_value_size(item);
+			return size;
+		}
+
+		template<typename T>
+		std::enable_if_t<is_associat_container<T>::value, size_t> json_value_size(const T &o);
+
+		template<typename T>
+		std::enable_if_t<is_sequence_container<T>::value || is_set_container<T>::value, size_t> json_value_size(const T &v);
+
+		template<typename T>
+		std::enable_if_t<is_associat_container<T>::value, size_t> json_value_size(const T &o) {
+			size_t size = o.empty() ? 2 : 1 + o.size() * 2;
+			for (auto &item : o)
+				size += json_key_size(item.first) + json_value_size(item.second);
+			return size;
+		}
+
+		template<typename T>
+		std::enable_if_t<is_sequence_container<T>::value || is_set_container<T>::value, size_t> json_value_size(const T &v) {
+			size_t size = v.empty() ? 2 : 1 + v.size();
+			for (auto &item : v)
+				size += json_value_size(item);
+			return size;
+		}
+
+		template<typename T, typename>
+		size_t serialized_size(const T &t) {
+			using M = Members<std::remove_const_t<std::remove_reference_t<T>>>;
+			size_t size = 1 + M::value;
+			for_each(t, [&size](const auto &v, auto I, bool) {
+				size += M::json_keys[I].size + json_value_size(v);
+			}, [&size](const auto &o, auto I, bool) {
+				size += M::json_keys[I].size + serialized_size(o);
+			});
+			return size;
+		}
+
+		namespace detail {
+			template<typename T, typename = void>
+			struct json_size_bound {
+				static constexpr bool fixed = false;
+				static constexpr size_t value = 0;
+			};
+
+			template<typename T>
+			struct json_size_bound<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> {
+				static constexpr bool fixed = true;
+				static constexpr size_t value = std::numeric_limits<T>::digits10 + 1 + std::is_signed<T>::value;
+			};
+
+			template<>
+			struct json_size_bound<bool> {
+				static constexpr bool fixed = true;
+				static constexpr size_t value = 5;
+			};
+
+			template<typename T>
+			struct json_size_bound<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+				static constexpr bool fixed = true;
+				static constexpr size_t value = float_json_size;
+			};
+
+			template<typename T>
+			struct json_size_bound<T, std::enable_if_t<std::is_enum<T>::value>> : json_size_bound<std::underlying_type_t<T>> {
+			};
+
+			template<typename T, size_t N>
+			struct json_size_bound<T[N]> {
+				static constexpr bool fixed = json_size_bound<T>::fixed;
+				static constexpr size_t value = 1 + N + N * json_size_bound<T>::value;
+			};
+
+			template<typename P>
+			struct member_value_type;
+
+			template<typename C, typename U>
+			struct member_value_type<U C::*> {
+				using type = U;
+			};
+
+			template<typename T, size_t I>
+			using member_type_t = typename member_value_type<std::tuple_element_t<I, decltype(Members<T>::apply())>>::type;
+
+			template<typename T, size_t... Is>
+			constexpr bool all_fixed(std::index_sequence<Is...>) {
+				constexpr bool fixed[] = { json_size_bound<member_type_t<T, Is>>::fixed... };
+				for (auto f : fixed) {
+					if (!f)
+						return false;
+				}
+				return true;
+			}
+
+			template<typename T, size_t... Is>
+			constexpr size_t sum_bounds(std::index_sequence<Is...>) {
+				using M = Members<T>;
+				constexpr size_t sizes[] = { (M::json_keys[Is].size + json_size_bound<member_type_t<T, Is>>::value)... };
+				size_t size = 1 + M::value;
+				for (auto s : sizes)
+					size += s;
+				return size;
+			}
+
+			template<typename T>
+			struct json_size_bound<T, std::enable_if_t<is_reflection<T>::value>> {
+				using indices = std::make_index_sequence<Members<T>::value>;
+				static constexpr bool fixed = all_fixed<T>(indices{});
+				static constexpr size_t value = sum_bounds<T>(indices{});
+			};
+		}
+
+		//compile time bound for types made only of numbers, bools, enums, fixed arrays
+		//and nested objects of them, e.g. char buf[json::max_serialized_size<point>()];
+		template<typename T>
+		constexpr std::enable_if_t<is_reflection<T>::value, size_t> max_serialized_size() {
+			static_assert(detail::json_size_bound<T>::fixed, "max_serialized_size needs a type made only of fixed-width fields");
+			return detail::json_size_bound<T>::value;
+		}
+
+		///*********************************** to json *********************************///
+		template<typename Stream, typename T, typename>
+		void to_json_impl(Stream& s, T &&t) {
+			s.put('{');
+			for_each(std::forward<T>(t),
+				[&s](const auto &v, auto I, bool is_last) { //magic for_each struct std::forward<T>(t)
+				write_json_key<T>(s, I);
+				render_json_value(s, v);
+				if (!is_last)
+					s.put(',');
+			}, [&s](const auto &o, auto I, bool is_last) {
+				write_json_key<T>(s, I);
+				to_json_impl(s, o);
+				if (!is_last)
+					s.put(',');
+			});
+			s.put('}');
+		}
+
+		//reserve once and write without per character capacity checks
+		template<typename Stream, typename T>
+		void to_json(Stream& s, T &&t, std::true_type) {
+			s.reserve(s.write_length() + serialized_size(t));
+			unchecked_stream us(s.m_write_ptr);
+			to_json_impl(us, std::forward<T>(t));
+			s.m_write_ptr = us.m_write_ptr;
+		}
+
+		template<typename Stream, typename T>
+		void to_json(Stream& s, T &&t, std::false_type) {
+			to_json_impl(s, std::forward<T>(t));
+		}
+
+		template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void to_json(Stream& s, T &&t) {
+			to_json(s, std::forward<T>(t), is_reservable_stream<Stream>{});
+		}
+
+		template<typename Stream, typename T>
+		void to_json(Stream& s, const std::vector<T> &v) {
+			render_json_value(s, v);
+		};
+
+		namespace detail {
+			//the elements of [first, last) comma separated, sized up front like to_json
+			template<typename InputIt>
+			string_stream render_chunk(InputIt first, InputIt last) {
+				size_t size = std::distance(first, last) - 1;
+				for (auto it = first; it != last; ++it)
+					size += json_value_size(*it);
+
+				string_stream ss;
+				ss.reserve(size);
+				unchecked_stream us(ss.m_write_ptr);
+				join(us, first, last, ',', [&us](const auto &jsv) {
+					render_json_value(us, jsv);
+				});
+				ss.m_write_ptr = us.m_write_ptr;
+				return ss;
+			}
+		}
+
+		//renders chunks of v on up to threads threads (0 for one per core) and
+		//writes them out in order, the output is the same as to_json(s, v);
+		//vectors shorter than two chunks of min_chunk elements stay serial
+		template<typename Stream, typename T>
+		void to_json_parallel(Stream& s, const std::vector<T> &v, size_t threads = 0, size_t min_chunk = 1024) {
+			if (threads == 0)
+				threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+			size_t chunks = (std::min)(threads, v.size() / (std::max)(min_chunk, size_t(1)));
+			if (chunks < 2) {
+				to_json(s, v);
+				return;
+			}
+
+			std::vector<std::future<string_stream>> parts;
+			parts.reserve(chunks);
+			size_t step = v.size() / chunks, rest = v.size() % chunks;
+			auto first = v.cbegin();
+			for (size_t i = 0; i < chunks; ++i) {
+				auto last = first + (step + (i < rest ? 1 : 0));
+				parts.push_back(std::async(std::launch::async, [first, last] {
+					return detail::render_chunk(first, last);
+				}));
+				first = last;
+			}
+
+			s.put('[');
+			for (size_t i = 0; i < chunks; ++i) {
+				string_stream part = parts[i].get();
+				if (i != 0)
+					s.put(',');
+				s.write(part.data(), part.write_length());
+			}
+			s.put(']');
+		}
+
+		template<typename Stream, typename... Args>
+		void to_json(Stream& s, const std::tuple<Args...> &tp) {
+			s.put('[');
+			apply_tuple([&s](const auto &v, size_t I, bool is_last) {
+				render_json_value(s, v);
+				if (!is_last)
+					s.put(',');
+			}, tp, std::make_index_sequence<sizeof...(Args)>{});
+			s.put(']');
+		}
+
+		///***********************************  from json*********************************///
+		//reader from ajson
+		namespace detail {
+			struct string_ref {
+				char const *str;
+				size_t len;
+			};
+
+			inline unsigned count_trailing_zeros64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+				unsigned long index;
+				_BitScanForward64(&index, mask);
+				return index;
+#elif defined(_MSC_VER)
+				return static_cast<uint32_t>(mask) != 0 ? count_trailing_zeros(static_cast<uint32_t>(mask))
+					: 32 + count_trailing_zeros(static_cast<uint32_t>(mask >> 32));
+#else
+				return __builtin_ctzll(mask);
+#endif
+			}
+
+			//character classes of a 64 byte block, one bit per byte
+			struct block_masks {
+				uint64_t quote;
+				uint64_t backslash;
+				uint64_t structural; //{ } [ ] : ,
+				uint64_t space;
+				uint64_t slash;
+				uint64_t nul;
+				uint64_t newline;
+			};
+
+#if defined(IGUANA_USE_AVX2)
+			inline block_masks classify_block(const char *p) {
+				const __m256i structural[] = { _mm256_set1_epi8('{'), _mm256_set1_epi8('}'), _mm256_set1_epi8('['),
+					_mm256_set1_epi8(']'), _mm256_set1_epi8(':'), _mm256_set1_epi8(',') };
+				const __m256i space[] = { _mm256_set1_epi8(' '), _mm256_set1_epi8('\t'), _mm256_set1_epi8('\r') };
+				block_masks m = {};
+				for (int i = 0; i < 2; ++i) {
+					const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+					__m256i st = _mm256_cmpeq_epi8(v, structural[0]);
+					for (int k = 1; k < 6; ++k)
+						st = _mm256_or_si256(st, _mm256_cmpeq_epi8(v, structural[k]));
+					const __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+					__m256i sp = nl;
+					for (int k = 0; k < 3; ++k)
+						sp = _mm256_or_si256(sp, _mm256_cmpeq_epi8(v, space[k]));
+					const int shift = 32 * i;
+					m.quote |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))))) << shift;
+					m.backslash |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))))) << shift;
+					m.slash |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))))) << shift;
+					m.nul |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())))) << shift;
+					m.newline |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(nl))) << shift;
+					m.structural |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(st))) << shift;
+					m.space |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(sp))) << shift;
+				}
+				return m;
+			}
+#elif defined(IGUANA_USE_SSE2)
+			inline block_masks classify_block(const char *p) {
+				const __m128i structural[] = { _mm_set1_epi8('{'), _mm_set1_epi8('}'), _mm_set1_epi8('['),
+					_mm_set1_epi8(']'), _mm_set1_epi8(':'), _mm_set1_epi8(',') };
+				const __m128i space[] = { _mm_set1_epi8(' '), _mm_set1_epi8('\t'), _mm_set1_epi8('\r') };
+				block_masks m = {};
+				for (int i = 0; i < 4; ++i) {
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+					__m128i st = _mm_cmpeq_epi8(v, structural[0]);
+					for (int k = 1; k < 6; ++k)
+						st = _mm_or_si128(st, _mm_cmpeq_epi8(v, structural[k]));
+					const __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+					__m128i sp = nl;
+					for (int k = 0; k < 3; ++k)
+						sp = _mm_or_si128(sp, _mm_cmpeq_epi8(v, space[k]));
+					const int shift = 16 * i;
+					m.quote |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << shift;
+					m.backslash |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << shift;
+					m.slash |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/'))))) << shift;
+					m.nul |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())))) << shift;
+					m.newline |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(nl))) << shift;
+					m.structural |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(st))) << shift;
+					m.space |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(sp))) << shift;
+				}
+				return m;
+			}
+#else
+			inline block_masks classify_block(const char *p) {
+				block_masks m = {};
+				for (int i = 0; i < 64; ++i) {
+					const uint64_t bit = uint64_t(1) << i;
+					switch (p[i]) {
+					case '"': m.quote |= bit; break;
+					case '\\': m.backslash |= bit; break;
+					case '/': m.slash |= bit; break;
+					case 0: m.nul |= bit; break;
+					case '{': case '}': case '[': case ']': case ':': case ',': m.structural |= bit; break;
+					case '\n': m.space |= bit; m.newline |= bit; break;
+					case ' ': case '\t': case '\r': m.space |= bit; break;
+					default: break;
+					}
+				}
+				return m;
+			}
+#endif
+
+			//bit i set when an odd number of quotes precede or sit at i
+			inline uint64_t prefix_xor(uint64_t x) {
+				x ^= x << 1;
+				x ^= x << 2;
+				x ^= x << 4;
+				x ^= x << 8;
+				x ^= x << 16;
+				x ^= x << 32;
+				return x;
+			}
+
+			//bytes escaped by a backslash; backslashes are rare so they are walked one by one
+			inline uint64_t escaped_mask(uint64_t backslash, uint64_t &carry) {
+				uint64_t escaped = carry;
+				carry = 0;
+				backslash &= ~escaped;
+				while (backslash != 0) {
+					unsigned i = count_trailing_zeros64(backslash);
+					if (i == 63) {
+						carry = 1;
+						break;
+					}
+					escaped |= uint64_t(2) << i;
+					backslash &= ~(uint64_t(3) << i);
+				}
+				return escaped;
+			}
+
+			constexpr uint32_t string_escape_flag = 0x80000000u;
+
+			//stage one of the reader: the offsets of every structural character, both
+			//quotes of every string and the first byte of every other scalar, found 64
+			//bytes at a time. false if the document has what only the byte by byte
+			//reader understands: comments, a '\0', which ends the input there, a line
+			//break inside a string, which is an error there, or a quote inside a bare
+			//word, which is part of the word there
+			inline bool build_structural_index(const char *ptr, size_t len, std::vector<uint32_t> &index) {
+				index.resize(len / 4 + 64);
+				size_t count = 0;
+				uint64_t escape_carry = 0, string_carry = 0, scalar_carry = 0;
+				bool pending_backslash = false;
+				char tail[64];
+				for (size_t base = 0; base < len; base += 64) {
+					const char *block = ptr + base;
+					uint64_t valid = ~uint64_t(0);
+					if (len - base < 64) {
+						memset(tail, ' ', sizeof(tail));
+						memcpy(tail, block, len - base);
+						block = tail;
+						valid >>= 64 - (len - base);
+					}
+
+					block_masks m = classify_block(block);
+					uint64_t quote = m.quote & ~escaped_mask(m.backslash, escape_carry);
+					uint64_t in_string = prefix_xor(quote) ^ string_carry;
+					string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+					if ((((m.slash & ~in_string) | m.nul | (m.newline & in_string)) & valid) != 0)
+						return false;
+
+					uint64_t scalar = ~(in_string | quote | m.structural | m.space);
+					uint64_t after_scalar = (scalar << 1) | scalar_carry;
+					if ((quote & in_string & after_scalar & valid) != 0)
+						return false;
+					uint64_t scalar_start = scalar & ~after_scalar;
+					scalar_carry = scalar >> 63;
+
+					uint64_t bits = ((m.structural & ~in_string) | quote | scalar_start) & valid;
+					if (index.size() - count < 64)
+						index.resize(index.size() * 2);
+					uint32_t *out = index.data() + count;
+					uint64_t backslash = m.backslash;
+					while (bits != 0) {
+						unsigned i = count_trailing_zeros64(bits);
+						uint64_t bit = uint64_t(1) << i;
+						uint32_t entry = static_cast<uint32_t>(base + i);
+						if ((quote & bit) != 0) {
+							//closing quotes of strings with a backslash are flagged
+							if ((in_string & bit) == 0 && (pending_backslash || (backslash & (bit - 1)) != 0))
+								entry |= string_escape_flag;
+							pending_backslash = false;
+							backslash &= ~((bit - 1) | bit);
+						}
+						*out++ = entry;
+						bits &= bits - 1;
+					}
+					pending_backslash = pending_backslash || (backslash & valid) != 0;
+					count = out - index.data();
+				}
+				index.resize(count);
+				return true;
+			}
+		}
+		struct token {
+			detail::string_ref str;
+			enum {
+				t_string,
+				t_int,
+				t_uint,
+				t_number,
+				t_ctrl,
+				t_end,
+			} type;
+			union {
+				int64_t i64;
+				uint64_t u64;
+				double d64;
+			} value;
+		};
+
+		namespace detail {
+			inline bool is_ctrl(const token &tok, char c) {
+				return tok.type == token::t_ctrl && tok.str.str[0] == c;
+			}
+
+			//the token of a number scanned from [begin, end)
+			inline void number_token(const iguana::detail::decimal_number &d, const char *begin, const char *end, token &tok) {
+				if (d.is_integer && !d.too_many_digits && d.exponent == 0) {
+					if (!d.negative) {
+						tok.type = token::t_uint;
+						tok.value.u64 = d.mantissa;
+					}
+					else if (d.mantissa != 0 && d.mantissa <= (uint64_t(1) << 63)) {
+						tok.type = token::t_int;
+						tok.value.i64 = static_cast<int64_t>(0 - d.mantissa);
+					}
+					else {
+						//-0 and below INT64_MIN
+						tok.type = token::t_number;
+						tok.value.d64 = -static_cast<double>(d.mantissa);
+					}
+				}
+				else {
+					tok.type = token::t_number;
+					tok.value.d64 = iguana::detail::to_double(d, begin, end);
+				}
+				tok.str.str = begin;
+				tok.str.len = end - begin;
+			}
+
+			//number tokens to members; false for other tokens and for negative numbers
+			//read into unsigned members
+			template<typename T>
+			std::enable_if_t<is_signed_intergral_like<T>::value, bool> store_number(const token &tok, T &val) {
+				switch (tok.type) {
+				case token::t_int:
+					val = static_cast<int>(tok.value.i64);
+					return true;
+				case token::t_uint:
+					val = static_cast<int>(tok.value.u64);
+					return true;
+				case token::t_number:
+					val = static_cast<int>(tok.value.d64);
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			template<typename T>
+			std::enable_if_t<is_unsigned_intergral_like<T>::value, bool> store_number(const token &tok, T &val) {
+				switch (tok.type) {
+				case token::t_int:
+					if (tok.value.i64 < 0)
+						return false;
+					val = static_cast<unsigned int>(tok.value.i64);
+					return true;
+				case token::t_uint:
+					val = static_cast<unsigned int>(tok.value.u64);
+					return true;
+				case token::t_number:
+					if (tok.value.d64 < 0)
+						return false;
+					val = static_cast<unsigned int>(tok.value.d64);
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			template<typename T>
+			std::enable_if_t<std::is_floating_point<T>::value, bool> store_number(const token &tok, T &val) {
+				switch (tok.type) {
+				case token::t_int:
+					val = static_cast<T>(tok.value.i64);
+					return true;
+				case token::t_uint:
+					val = static_cast<T>(tok.value.u64);
+					return true;
+				case token::t_number:
+					val = static_cast<T>(tok.value.d64);
+					return true;
+				default:
+					return false;
+				}
+			}
+		}
+
+		namespace detail {
+			inline unsigned popcount(uint32_t mask) {
+#if defined(_MSC_VER)
+				return __popcnt(mask);
+#else
+				return __builtin_popcount(mask);
+#endif
+			}
+
+			inline unsigned highest_bit(uint32_t mask) {
+#if defined(_MSC_VER)
+				unsigned long index;
+				_BitScanReverse(&index, mask);
+				return index;
+#else
+				return 31 - __builtin_clz(mask);
+#endif
+			}
+
+			//what next() does with the first byte of a token
+			enum char_class : unsigned char {
+				cc_word, cc_end, cc_ctrl, cc_slash, cc_quote, cc_digit, cc_minus, cc_space,
+			};
+
+			static const unsigned char char_classes[256] = {
+				1, 0, 0, 0, 0, 0, 0, 0, 0, 7, 7, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				7, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 6, 0, 3, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 2, 0, 0, 0, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+			};
+
+			inline bool is_space(char c) {
+				return char_classes[static_cast<unsigned char>(c)] == cc_space;
+			}
+
+			//the first byte in [p, end) that is not whitespace
+			inline const char* skip_space(const char *p, const char *end) {
+#ifdef IGUANA_USE_AVX2
+				for (; end - p >= 32; p += 32) {
+					const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					const __m256i sp = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+					const uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(sp));
+					if (other != 0)
+						return p + count_trailing_zeros(other);
+				}
+#endif
+#ifdef IGUANA_USE_SSE2
+				for (; end - p >= 16; p += 16) {
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+					const __m128i sp = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+					const uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(sp)) & 0xFFFF;
+					if (other != 0)
+						return p + count_trailing_zeros(other);
+				}
+#endif
+				while (p < end && is_space(*p))
+					++p;
+				return p;
+			}
+
+			//the first '"', '\\', '\n' or '\0' in [p, end), everything else is copied as is
+			inline const char* find_string_end(const char *p, const char *end) {
+#ifdef IGUANA_USE_AVX2
+				for (; end - p >= 32; p += 32) {
+					const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					const __m256i m = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+					const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(m));
+					if (mask != 0)
+						return p + count_trailing_zeros(mask);
+				}
+#endif
+#ifdef IGUANA_USE_SSE2
+				for (; end - p >= 16; p += 16) {
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+					const __m128i m = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_setzero_si128())));
+					const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(m));
+					if (mask != 0)
+						return p + count_trailing_zeros(mask);
+				}
+#endif
+				for (; p < end; ++p) {
+					if (*p == '"' || *p == '\\' || *p == '\n' || *p == 0)
+						return p;
+				}
+				return end;
+			}
+
+			//past the bracket closing the array or object whose body starts at p, by
+			//counting brackets outside strings; nullptr if it is not closed or holds a
+			//comment or '\0'
+			inline const char* match_bracket(const char *p, const char *end) {
+				size_t depth = 1;
+				while (p < end) {
+					switch (*p++) {
+					case '"':
+						for (;;) {
+							p = find_string_end(p, end);
+							if (p >= end || *p == '\n' || *p == 0)
+								return nullptr;
+							if (*p == '"')
+								break;
+							p += 2;
+						}
+						++p;
+						break;
+					case '[':
+					case '{':
+						++depth;
+						break;
+					case ']':
+					case '}':
+						if (--depth == 0)
+							return p;
+						break;
+					case '/':
+					case 0:
+						return nullptr;
+					default:
+						break;
+					}
+				}
+				return nullptr;
+			}
+
+			//the bytes count_elements cares about in a 64 byte block, one bit per byte
+			struct count_masks {
+				uint64_t quote;
+				uint64_t backslash;
+				uint64_t open;		//[ {
+				uint64_t close;		//] }
+				uint64_t comma;
+				uint64_t invalid;	//a comment or '\0'
+			};
+
+#ifdef IGUANA_USE_SSE2
+			inline count_masks classify_count_block(const char *p) {
+				count_masks m = {};
+				for (int i = 0; i < 4; ++i) {
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+					const __m128i open = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8('{')));
+					const __m128i close = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(']')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+					const __m128i invalid = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+					const int shift = 16 * i;
+					m.quote |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << shift;
+					m.backslash |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << shift;
+					m.open |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(open))) << shift;
+					m.close |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(close))) << shift;
+					m.comma |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(','))))) << shift;
+					m.invalid |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(invalid))) << shift;
+				}
+				return m;
+			}
+#else
+			inline count_masks classify_count_block(const char *p) {
+				count_masks m = {};
+				for (int i = 0; i < 64; ++i) {
+					const uint64_t bit = uint64_t(1) << i;
+					switch (p[i]) {
+					case '"': m.quote |= bit; break;
+					case '\\': m.backslash |= bit; break;
+					case '[': case '{': m.open |= bit; break;
+					case ']': case '}': m.close |= bit; break;
+					case ',': m.comma |= bit; break;
+					case '/': case 0: m.invalid |= bit; break;
+					default: break;
+					}
+				}
+				return m;
+			}
+#endif
+
+			inline unsigned popcount64(uint64_t mask) {
+				return popcount(static_cast<uint32_t>(mask)) + popcount(static_cast<uint32_t>(mask >> 32));
+			}
+
+			//number of elements of the array whose body starts at p: the commas outside
+			//strings and nested brackets, found 64 bytes at a time like the structural
+			//index. size_t(-1) if the array is not closed or has comments
+			inline size_t count_elements(const char *p, const char *end) {
+				p = skip_space(p, end);
+				if (p < end && *p == ']')
+					return 0;
+				size_t depth = 1;
+				size_t commas = 0;
+				uint64_t escape_carry = 0, string_carry = 0;
+				char tail[64];
+				for (; p < end; p += 64) {
+					const char *block = p;
+					uint64_t valid = ~uint64_t(0);
+					if (end - p < 64) {
+						memset(tail, ' ', sizeof(tail));
+						memcpy(tail, p, end - p);
+						block = tail;
+						valid >>= 64 - (end - p);
+					}
+
+					count_masks m = classify_count_block(block);
+					uint64_t quote = m.quote & ~escaped_mask(m.backslash, escape_carry);
+					uint64_t in_string = prefix_xor(quote) ^ string_carry;
+					string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+					uint64_t outside = ~in_string & valid;
+					if ((m.invalid & outside) != 0)
+						return size_t(-1);
+
+					uint64_t comma = m.comma & outside;
+					uint64_t open = m.open & outside;
+					uint64_t brackets = (m.open | m.close) & outside;
+					//commas before the first bracket, between brackets and after the last
+					uint64_t from = ~uint64_t(0);
+					while (brackets != 0) {
+						uint64_t bit = brackets & (~brackets + 1);
+						if (depth == 1)
+							commas += popcount64(comma & from & (bit - 1));
+						if ((open & bit) != 0) {
+							++depth;
+						}
+						else if (--depth == 0) {
+							return commas + 1;
+						}
+						from = ~((bit - 1) | bit);
+						brackets &= brackets - 1;
+					}
+					if (depth == 1)
+						commas += popcount64(comma & from);
+				}
+				return size_t(-1);
+			}
+		}
+
+#ifndef IGUANA_JSON_INDEX_THRESHOLD
+#define IGUANA_JSON_INDEX_THRESHOLD (64 * 1024)
+#endif
+
+		class reader_t {
+		public:
+			reader_t(const char *ptr = nullptr, size_t len = -1) : len_(len), ptr_(ptr) {
+				init();
+			}
+
+			//errors are kept for get_error() instead of thrown
+			reader_t(const char *ptr, size_t len, const std::nothrow_t&) : len_(len), ptr_(ptr) {
+				throws_ = false;
+				init();
+			}
+
+			//in situ: strings with escapes are decoded over their own bytes in ptr, so
+			//every string token points into the buffer
+			reader_t(char *ptr, size_t len, bool insitu) : len_(len), ptr_(ptr) {
+				if (insitu)
+					insitu_ = ptr;
+				init();
+			}
+
+			static inline char *itoa_native(size_t val, char *buffer, size_t len) {
+				buffer[len] = 0;
+				size_t pos = len - 1;
+				if (val == 0) {
+					buffer[pos--] = '0';
+				}
+				while (val) {
 					buffer[pos--] = (char)((val % 10) + '0');
 					val = val / 10;
 				}
@@ -377,781 +1557,2223 @@ namespace iguana {
 				return &buffer[0] + pos;
 			}
 
-			inline void error(const char *message) const {
-				char buffer[20];
-				std::string msg = "error at line :";
-				msg += itoa_native(cur_line_, buffer, 19);
-				msg += " col :";
-				msg += itoa_native(cur_col_, buffer, 19);
-				msg += " msg:";
-				msg += message;
-				throw std::invalid_argument(msg);
+			//keeps the first error, then throws, or in nothrow mode ends the input so
+			//every loop reading it stops at t_end
+			void error(errc code, const char *message) {
+				if (code_ == errc::ok) {
+					code_ = cur_tok_.type == token::t_end ? errc::unexpected_end : code;
+					message_ = message;
+					error_offset_ = (std::min)(cur_offset_, len_);
+				}
+				if (throws_)
+					iguana::detail::throw_invalid_argument(describe_error());
+
+				end_mark_ = true;
+				cur_offset_ = len_;
+				index_pos_ = index_.size();
+				cur_tok_.type = token::t_end;
+				cur_tok_.str.str = "";
+				cur_tok_.str.len = 1;
+			}
+
+			inline bool failed() const {
+				return code_ != errc::ok;
+			}
+
+			parse_error get_error() const {
+				parse_error e;
+				e.code = code_;
+				e.offset = error_offset_;
+				e.path = path_;
+				return e;
+			}
+
+			//called by readers returning from a failed member, innermost first
+			inline void push_path(const char *name, size_t len) {
+				iguana::detail::push_path(path_, name, len);
+			}
+
+			inline void push_path(size_t index) {
+				iguana::detail::push_path(path_, index);
+			}
+
+			//only the offset is tracked while reading, lines are counted when there is an
+			//error to report
+			std::string describe_error() const {
+				const char *end = ptr_ + error_offset_;
+				const char *last_line = ptr_;
+				size_t line = 0;
+				for (const char *p = ptr_; (p = static_cast<const char*>(memchr(p, '\n', end - p))) != nullptr; ) {
+					++line;
+					last_line = ++p;
+				}
+				size_t col = end - last_line;
+
+				char buffer[20];
+				std::string msg = "error at line :";
+				msg += itoa_native(line, buffer, 19);
+				msg += " col :";
+				msg += itoa_native(col, buffer, 19);
+				msg += " msg:";
+				msg += message_;
+				return msg;
+			}
+
+			inline token const &peek() const {
+				return cur_tok_;
+			}
+
+			void next() {
+				if (indexed_) {
+					next_indexed();
+					return;
+				}
+
+				auto c = skip();
+				bool do_next = false;
+				switch (detail::char_classes[static_cast<unsigned char>(c)]) {
+				case detail::cc_end:
+					cur_tok_.type = token::t_end;
+					cur_tok_.str.str = "";
+					cur_tok_.str.len = 1;
+					break;
+				case detail::cc_ctrl: {
+					cur_tok_.type = token::t_ctrl;
+					cur_tok_.str.str = ptr_ + cur_offset_;
+					cur_tok_.str.len = 1;
+					take();
+					break;
+				}
+				case detail::cc_slash: {
+					take();
+					c = read();
+					if (c == '/') {
+						take();
+						c = read();
+						while (c != '\n' && c != 0) {
+							take();
+							c = read();
+						}
+						do_next = true;
+						break;
+					}
+					else if (c == '*') {
+						take();
+						c = read();
+						do {
+							while (c != '*') {
+								if (c == 0) {
+									error(errc::invalid_comment, "not a comment!");
+									return;
+								}
+								take();
+								c = read();
+							}
+							take();
+							c = read();
+							if (c == '/') {
+								take();
+								do_next = true;
+								break;
+							}
+						} while (true);
+						break;
+					}
+					//error parser comment
+					error(errc::invalid_comment, "not a comment!");
+					return;
+				}
+				case detail::cc_quote: {
+					cur_tok_.type = token::t_string;
+					parser_quote_string();
+					break;
+				}
+				case detail::cc_digit:
+				case detail::cc_minus: {
+					parser_number();
+					break;
+				}
+				default: {
+					cur_tok_.type = token::t_string;
+					parser_string();
+				}
+				}
+				if (do_next == false)
+					return;
+				next();
+			}
+
+			inline bool expect(char c) {
+				return cur_tok_.str.str[0] == c;
+			}
+
+			//where strings read into views go when they had escapes
+			inline void use_arena(arena &a) {
+				arena_ = &a;
+			}
+
+			//containers are overwritten instead of appended to, reusing their storage
+			//and elements
+			inline void set_reuse(bool reuse) {
+				reuse_ = reuse;
+			}
+
+			inline bool reuse() const {
+				return reuse_;
+			}
+
+			//the current string as bytes that outlive the reader: the input itself, or a
+			//copy in the arena if it was decoded. nullptr if it needs an arena and there is none
+			const char *stable_string() const {
+				const char *s = cur_tok_.str.str;
+				if (s >= ptr_ && s <= ptr_ + len_)
+					return s;
+				if (arena_ == nullptr)
+					return nullptr;
+				return arena_->copy(s, cur_tok_.str.len);
+			}
+
+			//end of the current token, or of the whitespace before the next one
+			inline size_t offset() const {
+				return cur_offset_;
+			}
+
+			//stores up to n numbers of an array straight from the input, starting with the
+			//current token, without making tokens for the commas between them. stops at
+			//anything else and leaves the reader as if each number had been read with
+			//read_json, i.e. at the token after the last one stored
+			template<typename T>
+			size_t read_numbers(T *out, size_t n) {
+				if (n == 0 || !detail::store_number(cur_tok_, out[0]))
+					return 0;
+				size_t count = 1;
+				const char *end = ptr_ + len_;
+				iguana::detail::decimal_number d;
+				token tok;
+				while (count < n && !end_mark_) {
+					//most arrays have no spaces, skip_space is only called for those that do
+					const char *p = ptr_ + cur_offset_;
+					if (detail::is_space(*p))
+						p = detail::skip_space(p, end);
+					if (p == end || *p != ',')
+						break;
+					const char *begin = p + 1;
+					if (begin != end && detail::is_space(*begin))
+						begin = detail::skip_space(begin, end);
+					const char *q = iguana::detail::scan_number(begin, end, d);
+					if (q == nullptr)
+						break;
+					//in the index a number in an array is its first byte after the comma
+					if (indexed_ && (index_.size() - index_pos_ < 2 || index_[index_pos_] != p - ptr_ || index_[index_pos_ + 1] != begin - ptr_))
+						break;
+					detail::number_token(d, begin, q, tok);
+					if (!detail::store_number(tok, out[count]))
+						break;
+					++count;
+					cur_offset_ = q - ptr_;
+					if (indexed_)
+						index_pos_ += 2;
+					if (q == end || *q == 0)
+						end_mark_ = true;
+				}
+				next();
+				return count;
+			}
+
+			//when the current token is '[', the number of elements in the array without
+			//moving; 0 if it is empty or they cannot be counted. a trailing comma counts
+			//as one more, so it is only good for reserving
+			size_t count_elements() const {
+				if (end_mark_)
+					return 0;
+				size_t n = detail::count_elements(ptr_ + cur_offset_, ptr_ + len_);
+				return n == size_t(-1) ? 0 : n;
+			}
+
+			//when the current token is '[' or '{', moves past the matching bracket without
+			//tokenizing or checking what is in between. returns false and leaves the
+			//reader as it was if the brackets are unbalanced or the body has comments
+			bool skip_container() {
+				if (indexed_) {
+					size_t depth = 1;
+					for (size_t pos = index_pos_; pos < index_.size(); ++pos) {
+						uint32_t off = index_[pos];
+						switch (ptr_[off]) {
+						case '"':
+							//its closing quote is the next entry
+							++pos;
+							break;
+						case '[':
+						case '{':
+							++depth;
+							break;
+						case ']':
+						case '}':
+							if (--depth == 0) {
+								index_pos_ = pos + 1;
+								cur_offset_ = off + 1;
+								next_indexed();
+								return true;
+							}
+							break;
+						default:
+							break;
+						}
+					}
+					return false;
+				}
+
+				const char *q = end_mark_ ? nullptr : detail::match_bracket(ptr_ + cur_offset_, ptr_ + len_);
+				if (q == nullptr)
+					return false;
+				cur_offset_ = q - ptr_;
+				if (cur_offset_ >= len_)
+					end_mark_ = true;
+				next();
+				return true;
+			}
+
+		private:
+			void init() {
+				if (ptr_ == nullptr) {
+					end_mark_ = true;
+				}
+				else if (len_ == 0) {
+					end_mark_ = true;
+				}
+				else if (ptr_[0] == 0) {
+					end_mark_ = true;
+				}
+				if (len_ == size_t(-1) && ptr_ != nullptr)
+					len_ = strlen(ptr_);
+				//large documents are walked through a structural index, offsets use 31 bits
+				if (!end_mark_ && len_ >= IGUANA_JSON_INDEX_THRESHOLD && len_ < detail::string_escape_flag) {
+					indexed_ = detail::build_structural_index(ptr_, len_, index_);
+				}
+				next();
+			}
+
+			//jumps to the next structural offset; quoted strings come with their closing
+			//quote so their bodies are not scanned unless they have escapes
+			void next_indexed() {
+				//what is left of a scalar the last token did not take all of, like the abc
+				//of 12abc, is read on byte by byte, so it is rejected the same way
+				size_t next_offset = index_pos_ == index_.size() ? len_ : index_[index_pos_];
+				if (cur_offset_ < next_offset && !end_mark_ && !detail::is_space(ptr_[cur_offset_])) {
+					char c = ptr_[cur_offset_];
+					if ((c >= '0' && c <= '9') || c == '-') {
+						parser_number();
+					}
+					else {
+						cur_tok_.type = token::t_string;
+						parser_string();
+					}
+					return;
+				}
+
+				if (index_pos_ == index_.size()) {
+					cur_offset_ = len_;
+					end_mark_ = true;
+					cur_tok_.type = token::t_end;
+					cur_tok_.str.str = "";
+					cur_tok_.str.len = 1;
+					return;
+				}
+
+				cur_offset_ = index_[index_pos_++];
+				end_mark_ = false;
+				char c = ptr_[cur_offset_];
+				switch (c) {
+				case '{':
+				case '}':
+				case '[':
+				case ']':
+				case ':':
+				case ',':
+					cur_tok_.type = token::t_ctrl;
+					cur_tok_.str.str = ptr_ + cur_offset_;
+					cur_tok_.str.len = 1;
+					++cur_offset_;
+					break;
+				case '"': {
+					if (index_pos_ == index_.size()) {
+						//not closed, read it byte by byte to fail where that would
+						cur_tok_.type = token::t_string;
+						parser_quote_string();
+						return;
+					}
+					uint32_t close = index_[index_pos_++];
+					cur_tok_.type = token::t_string;
+					if ((close & detail::string_escape_flag) != 0) {
+						close &= ~detail::string_escape_flag;
+						parser_quote_string();
+						if (failed())
+							return;
+					}
+					else {
+						cur_tok_.str.str = ptr_ + cur_offset_ + 1;
+						cur_tok_.str.len = close - cur_offset_ - 1;
+					}
+					cur_offset_ = close + 1;
+					break;
+				}
+				default:
+					if ((c >= '0' && c <= '9') || c == '-') {
+						parser_number();
+					}
+					else {
+						cur_tok_.type = token::t_string;
+						parser_string();
+					}
+				}
+			}
+
+			inline char read() const {
+				if (end_mark_)
+					return 0;
+				return ptr_[cur_offset_];
+			}
+
+			inline void take() {
+				if (end_mark_ == false) {
+					++cur_offset_;
+					if (cur_offset_ >= len_ || ptr_[cur_offset_] == 0)
+						end_mark_ = true;
+				}
+			}
+
+			char skip() {
+				auto c = read();
+				if (!detail::is_space(c))
+					return c;
+
+				const char *q = detail::skip_space(ptr_ + cur_offset_ + 1, ptr_ + len_);
+				cur_offset_ = q - ptr_;
+				if (cur_offset_ >= len_ || *q == 0)
+					end_mark_ = true;
+				return read();
+			}
+
+			//called on the first backslash of the string at start: decoded strings are
+			//built in scratch_, or in situ behind the read position, which only moves
+			//ahead faster as escapes are never shorter than what they stand for
+			inline void begin_escapes(const char *start) {
+				if (insitu_ != nullptr)
+					out_ = insitu_ + cur_offset_;
+				else
+					scratch_.assign(start, ptr_ + cur_offset_ - start);
+			}
+
+			inline void fill_escape_char(char c) {
+				if (insitu_ != nullptr)
+					*out_++ = c;
+				else
+					scratch_.push_back(c);
+			}
+
+			inline void fill_escape_run(const char *p, size_t n) {
+				if (insitu_ != nullptr) {
+					memmove(out_, p, n);
+					out_ += n;
+				}
+				else {
+					scratch_.append(p, n);
+				}
+			}
+
+			inline void end_escapes(const char *start) {
+				if (insitu_ != nullptr) {
+					cur_tok_.str.str = start;
+					cur_tok_.str.len = out_ - start;
+				}
+				else {
+					cur_tok_.str.str = scratch_.data();
+					cur_tok_.str.len = scratch_.size();
+				}
+			}
+
+			char table[103] = {
+					16, 16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 16, 17, 17, 16,
+					16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+					16, 16, 17, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+					16, 16, 16, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 16, 16, 16, 16, 16,
+					16, 16, 10, 11, 12, 13, 14, 15, 16, 16, 16, 16, 16, 16, 16, 16,
+					16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+					16, 16, 10, 11, 12, 13, 14, 15 };
+
+			inline char char_to_hex(char v) {
+				if (static_cast<unsigned char>(v) <= 'f') {
+					v = table[static_cast<unsigned char>(v)];
+				}
+				else {
+					v = 16;
+				}
+				if (v > 15) {
+					error(errc::invalid_escape, "utf8 code error!");
+					return 0;
+				}
+				return v;
+			}
+
+			inline uint64_t read_utf() {
+				char v = char_to_hex(read());
+				uint64_t utf = v;
+				utf <<= 4;
+				take();
+				v = char_to_hex(read());
+				utf += v;
+				utf <<= 4;
+				take();
+				v = char_to_hex(read());
+				utf += v;
+				utf <<= 4;
+				take();
+				v = char_to_hex(read());
+				utf += v;
+				take();
+				return utf;
+			}
+
+			//a \uXXXX escape, or two of them for a utf-16 surrogate pair
+			inline void esacpe_utf8() {
+				uint64_t utf1 = read_utf();
+				if (failed())
+					return;
+				if (utf1 >= 0xD800 && utf1 < 0xE000) {
+					if (utf1 >= 0xDC00 || read() != '\\') {
+						error(errc::invalid_escape, "invalid surrogate pair!");
+						return;
+					}
+					take();
+					if (read() != 'u') {
+						error(errc::invalid_escape, "invalid surrogate pair!");
+						return;
+					}
+					take();
+					uint64_t utf2 = read_utf();
+					if (utf2 < 0xDC00 || utf2 >= 0xE000) {
+						error(errc::invalid_escape, "invalid surrogate pair!");
+						return;
+					}
+					utf1 = 0x10000 + ((utf1 - 0xD800) << 10) + (utf2 - 0xDC00);
+				}
+
+				if (utf1 < 0x80) {
+					fill_escape_char((char)utf1);
+				}
+				else if (utf1 < 0x800) {
+					fill_escape_char((char)(0xC0 | (utf1 >> 6)));
+					fill_escape_char((char)(0x80 | (utf1 & 0x3F)));
+				}
+				else if (utf1 < 0x10000) {
+					fill_escape_char((char)(0xE0 | (utf1 >> 12)));
+					fill_escape_char((char)(0x80 | ((utf1 >> 6) & 0x3F)));
+					fill_escape_char((char)(0x80 | (utf1 & 0x3F)));
+				}
+				else {
+					fill_escape_char((char)(0xF0 | (utf1 >> 18)));
+					fill_escape_char((char)(0x80 | ((utf1 >> 12) & 0x3F)));
+					fill_escape_char((char)(0x80 | ((utf1 >> 6) & 0x3F)));
+					fill_escape_char((char)(0x80 | (utf1 & 0x3F)));
+				}
+			}
+
+			//the byte a one letter escape stands for, 0 for unknown escapes
+			static inline char escaped_char(char c) {
+				switch (c) {
+				case 'b': return '\b';
+				case 'f': return '\f';
+				case 'n': return '\n';
+				case 'r': return '\r';
+				case 't': return '\t';
+				case '"': return '"';
+				case '\\': return '\\';
+				case '/': return '/';
+				default: return 0;
+				}
+			}
+
+			//the token points into the input unless the string has escapes and the reader
+			//is not in situ, then it is decoded into scratch_ and valid until the next
+			//escaped string
+			void parser_quote_string() {
+				take();
+				const char *start = ptr_ + cur_offset_;
+				cur_tok_.str.str = start;
+				bool escaped = false;
+				auto c = read();
+				do {
+					//plain runs are skipped in bulk, and copied once there was an escape
+					if (!end_mark_) {
+						const char *p = ptr_ + cur_offset_;
+						const char *q = detail::find_string_end(p, ptr_ + len_);
+						cur_offset_ = q - ptr_;
+						if (cur_offset_ >= len_)
+							end_mark_ = true;
+						if (escaped)
+							fill_escape_run(p, q - p);
+						c = read();
+					}
+					switch (c) {
+					case '\\': {
+						if (!escaped) {
+							escaped = true;
+							begin_escapes(start);
+						}
+						take();
+						c = read();
+						if (c == 'u') {
+							take();
+							esacpe_utf8();
+							if (failed())
+								return;
+							continue;
+						}
+						c = escaped_char(c);
+						if (c == 0) {
+							error(errc::invalid_escape, "unknown escape char!");
+							return;
+						}
+						fill_escape_char(c);
+						take();
+						break;
+					}
+					case '"': {
+						if (escaped) {
+							end_escapes(start);
+						}
+						else {
+							cur_tok_.str.len = ptr_ + cur_offset_ - start;
+						}
+						take();
+						return;
+					}
+					default: {
+						error(errc::invalid_string, "not a valid quote string!");
+						return;
+					}
+					}
+				} while (true);
+			}
+
+			//a bare word, decoded like a quoted string
+			void parser_string() {
+				const char *start = ptr_ + cur_offset_;
+				cur_tok_.str.str = start;
+				bool escaped = false;
+				take();
+				auto c = read();
+				do {
+					switch (c) {
+					case 0:
+					case '\n': {
+						error(errc::invalid_string, "not a valid string!");
+						return;
+					}
+					case '\\': {
+						if (!escaped) {
+							escaped = true;
+							begin_escapes(start);
+						}
+						take();
+						c = read();
+						if (c == 'u') {
+							take();
+							esacpe_utf8();
+							if (failed())
+								return;
+							c = read();
+							continue;
+						}
+						c = escaped_char(c);
+						if (c == 0) {
+							error(errc::invalid_escape, "unknown escape char!");
+							return;
+						}
+						fill_escape_char(c);
+						take();
+						c = read();
+						continue;
+					}
+					case ' ':
+					case '\t':
+					case '\r':
+					case ',':
+					case '[':
+					case ']':
+					case ':':
+					case '{':
+					case '}': {
+						if (escaped) {
+							end_escapes(start);
+						}
+						else {
+							cur_tok_.str.len = ptr_ + cur_offset_ - start;
+						}
+						return;
+					}
+					}
+					if (escaped)
+						fill_escape_char(c);
+					take();
+					c = read();
+				} while (true);
+			}
+
+			//integers of up to 19 digits stay exact as t_int/t_uint, everything else
+			//is rounded once to the nearest double
+			void parser_number() {
+				const char *begin = ptr_ + cur_offset_;
+				const char *end = ptr_ + len_;
+				iguana::detail::decimal_number d;
+				const char *p = iguana::detail::scan_number(begin, end, d);
+				if (p == nullptr) {
+					error(errc::invalid_number, "not a valid number!");
+					return;
+				}
+
+				detail::number_token(d, begin, p, cur_tok_);
+				cur_offset_ += p - begin;
+				if (p == end || *p == 0)
+					end_mark_ = true;
+			}
+
+			token cur_tok_ = {};
+			size_t len_ = 0;
+			size_t cur_offset_ = 0;
+			bool end_mark_ = false;
+			const char *ptr_;
+			std::string scratch_;
+			char *insitu_ = nullptr;
+			char *out_ = nullptr;
+			arena *arena_ = nullptr;
+			bool indexed_ = false;
+			bool throws_ = true;
+			bool reuse_ = false;
+			errc code_ = errc::ok;
+			const char *message_ = "";
+			size_t error_offset_ = 0;
+			std::string path_;
+			std::vector<uint32_t> index_;
+			size_t index_pos_ = 0;
+		};
+
+		void skip(reader_t &rd);
+
+		inline void skip_array(reader_t &rd) {
+			while (!detail::is_ctrl(rd.peek(), ']')) {
+				skip(rd);
+				if (detail::is_ctrl(rd.peek(), ',')) {
+					rd.next();
+				}
+				else if (!detail::is_ctrl(rd.peek(), ']')) {
+					rd.error(errc::invalid_array, "no valid array!");
+					return;
+				}
+			}
+			rd.next();
+		}
+
+		inline void skip_key(reader_t &rd) {
+			auto &tok = rd.peek();
+			switch (tok.type) {
+			case token::t_string:
+			case token::t_int:
+			case token::t_uint:
+			case token::t_number: {
+				rd.next();
+				return;
+			}
+			default:
+				break;
+			}
+			rd.error(errc::invalid_document, "invalid json document!");
+		}
+
+		inline void skip_object(reader_t &rd) {
+			while (!detail::is_ctrl(rd.peek(), '}')) {
+				skip_key(rd);
+				if (!detail::is_ctrl(rd.peek(), ':')) {
+					rd.error(errc::invalid_document, "invalid json document!");
+					return;
+				}
+				rd.next();
+				skip(rd);
+				if (detail::is_ctrl(rd.peek(), ',')) {
+					rd.next();
+				}
+				else if (!detail::is_ctrl(rd.peek(), '}')) {
+					rd.error(errc::invalid_object, "no valid object!");
+					return;
+				}
+			}
+			rd.next();
+		}
+
+		inline void skip(reader_t &rd) {
+			auto &tok = rd.peek();
+			switch (tok.type) {
+			case token::t_string:
+			case token::t_int:
+			case token::t_uint:
+			case token::t_number: {
+				rd.next();
+				return;
+			}
+			case token::t_ctrl: {
+				if (tok.str.str[0] == '[') {
+					rd.next();
+					skip_array(rd);
+					return;
+				}
+				else if (tok.str.str[0] == '{') {
+					rd.next();
+					skip_object(rd);
+					return;
+				}
+			}
+			default:
+				break;
+			}
+			rd.error(errc::invalid_document, "invalid json document!");
+		}
+
+		//read json to value
+		template<typename T>
+		std::enable_if_t<is_signed_intergral_like<T>::value> read_json(reader_t &rd, T &val) {
+			auto &tok = rd.peek();
+			if (tok.type == token::t_string) {
+				int64_t temp = std::strtoll(tok.str.str, nullptr, 10);
+				val = static_cast<int>(temp);
+			}
+			else if (!detail::store_number(tok, val)) {
+				rd.error(errc::type_mismatch, "not a valid signed integral like number.");
+				return;
+			}
+			rd.next();
+		}
+
+		template<typename T>
+		inline std::enable_if_t<is_unsigned_intergral_like<T>::value> read_json(reader_t &rd, T &val) {
+			auto &tok = rd.peek();
+			if (tok.type == token::t_string) {
+				uint64_t temp = std::strtoull(tok.str.str, nullptr, 10);
+				val = static_cast<unsigned int>(temp);
+			}
+			else if (tok.type == token::t_int && tok.value.i64 < 0) {
+				rd.error(errc::out_of_range, "assign a negative signed integral to unsigned integral number.");
+				return;
+			}
+			else if (tok.type == token::t_number && tok.value.d64 < 0) {
+				rd.error(errc::out_of_range, "assign a negative float point to unsigned integral number.");
+				return;
+			}
+			else if (!detail::store_number(tok, val)) {
+				rd.error(errc::type_mismatch, "not a valid unsigned integral like number.");
+				return;
+			}
+			rd.next();
+		}
+
+		template<typename T>
+		inline std::enable_if_t<std::is_enum<T>::value> read_json(reader_t &rd, T &val) {
+			typedef typename std::underlying_type<T>::type RAW_TYPE;
+			read_json(rd, (RAW_TYPE&)val);
+		}
+
+		template<typename T>
+		inline std::enable_if_t<std::is_floating_point<T>::value> read_json(reader_t &rd, T &val) {
+			auto& tok = rd.peek();
+			if (tok.type == token::t_string)
+			{
+				double temp = std::strtold(tok.str.str, nullptr);
+				val = static_cast<T>(temp);
+			}
+			else if (!detail::store_number(tok, val))
+			{
+				rd.error(errc::type_mismatch, "not a valid float point number.");
+				return;
+			}
+			rd.next();
+		}
+
+		inline void read_json(reader_t &rd, bool &val) {
+			auto& tok = rd.peek();
+			switch (tok.type)
+			{
+			case token::t_string:
+			{
+				char const * ptr = tok.str.str;
+				if (tok.str.len == 4)
+				{
+					val = (ptr[0] == 't' || ptr[0] == 'T') &&
+						(ptr[1] == 'r' || ptr[1] == 'R') &&
+						(ptr[2] == 'u' || ptr[2] == 'U') &&
+						(ptr[3] == 'e' || ptr[3] == 'E');
+				}
+				else
+				{
+					val = false;
+				}
+				break;
+			}
+			case token::t_int:
+			{
+				val = (tok.value.i64 != 0);
+				break;
+			}
+			case token::t_uint:
+			{
+				val = (tok.value.u64 != 0);
+				break;
+			}
+			case token::t_number:
+			{
+				val = (tok.value.d64 != 0.0);
+				break;
+			}
+			default:
+			{
+				rd.error(errc::type_mismatch, "not a valid bool.");
+				return;
+			}
+			}
+			rd.next();
+		}
+
+		template<typename T>
+		std::enable_if_t<is_char_string<T>::value> read_json(reader_t &rd, T &val) {
+			auto &tok = rd.peek();
+			if (tok.type != token::t_string) {
+				rd.error(errc::type_mismatch, "not a valid string.");
+				return;
+			}
+			iguana::detail::adopt_current_arena(val);
+			val.assign(tok.str.str, tok.str.len);
+			rd.next();
+		}
+
+		//points into the input, strings with escapes need an arena to outlive the reader
+		template<typename T>
+		std::enable_if_t<is_string_view<T>::value> read_json(reader_t &rd, T &val) {
+			auto &tok = rd.peek();
+			if (tok.type != token::t_string) {
+				rd.error(errc::type_mismatch, "not a valid string.");
+				return;
+			}
+			const char *s = rd.stable_string();
+			if (s == nullptr) {
+				rd.error(errc::needs_arena, "escaped string needs an arena.");
+				return;
+			}
+			val = T(s, tok.str.len);
+			rd.next();
+		}
+
+		template <typename T, size_t N>
+		void read_json(reader_t &rd, T(&val)[N])
+		{
+			auto& tok = rd.peek();
+			if (tok.type == token::t_string)
+			{
+				size_t len = tok.str.len;
+				if (len > N)
+					len = N;
+				memcpy(val, tok.str.str, len);
+				if (len < N)
+					val[len] = 0;
+			}
+			else
+			{
+				rd.error(errc::type_mismatch, "not a valid string.");
+				return;
+			}
+			rd.next();
+		}
+
+		template<typename T>
+		std::enable_if_t<is_emplace_back_able<T>::value> emplace_back(T &val) {
+			val.emplace_back();
+		}
+
+		template<typename T>
+		std::enable_if_t<is_template_instant_of<std::queue, T>::value> emplace_back(T &val) {
+			val.emplace();
+		}
+
+		namespace detail {
+			template<typename T>
+			struct is_number_vector : std::integral_constant<bool,
+				is_template_instant_of<std::vector, T>::value &&
+				std::is_arithmetic<typename T::value_type>::value &&
+				!std::is_same<typename T::value_type, bool>::value> {};
+
+			//counting costs a pass over the array, more than growing by doubling does
+			//when elements move cheaply; it pays for numbers, which are then read in
+			//bulk, and for elements that are copied when the storage grows
+			template<typename T>
+			struct counts_elements : std::integral_constant<bool, has_reserve<T>::value &&
+				(is_number_vector<T>::value || !std::is_nothrow_move_constructible<typename T::value_type>::value)> {};
+
+			//reserves for the array the reader is at, before it is entered
+			template<typename T>
+			std::enable_if_t<counts_elements<T>::value, size_t> reserve_elements(reader_t &rd, T &val) {
+				size_t count = rd.count_elements();
+				if (count != 0)
+					val.reserve((rd.reuse() ? 0 : val.size()) + count);
+				return count;
 			}
 
-			inline token const &peek() const {
-				return cur_tok_;
+			template<typename T>
+			std::enable_if_t<!counts_elements<T>::value, size_t> reserve_elements(reader_t &, T &) {
+				return 0;
 			}
 
-			void next() {
-				auto c = skip();
-				bool do_next = false;
-				switch (c) {
-				case 0:
-					cur_tok_.type = token::t_end;
-					cur_tok_.str.str = ptr_ + cur_offset_;
-					cur_tok_.str.len = 1;
-					break;
-				case '{':
-				case '}':
-				case '[':
-				case ']':
-				case ':':
-				case ',': {
-					cur_tok_.type = token::t_ctrl;
-					cur_tok_.str.str = ptr_ + cur_offset_;
-					cur_tok_.str.len = 1;
-					take();
-					break;
+			template<typename T>
+			void read_elements(reader_t &rd, T &val, size_t, std::false_type) {
+				size_t index = 0;
+				while (!detail::is_ctrl(rd.peek(), ']')) {
+					emplace_back(val);
+					read_json(rd, val.back());
+					if (rd.failed()) {
+						rd.push_path(index);
+						return;
+					}
+					++index;
+					if (detail::is_ctrl(rd.peek(), ',')) {
+						rd.next();
+					}
+					else if (!detail::is_ctrl(rd.peek(), ']')) {
+						rd.error(errc::invalid_array, "no valid array!");
+						return;
+					}
 				}
-				case '/': {
-					take();
-					c = read();
-					if (c == '/') {
-						take();
-						c = read();
-						while (c != '\n' && c != 0) {
-							take();
-							c = read();
-						}
-						do_next = true;
-						break;
+			}
+
+			//in reuse mode elements already there are read over, keeping what they own,
+			//and the ones left over at the end are dropped
+			template<typename T>
+			std::enable_if_t<is_emplace_back_able<T>::value> overwrite_elements(reader_t &rd, T &val) {
+				auto it = val.begin();
+				size_t index = 0;
+				while (!detail::is_ctrl(rd.peek(), ']')) {
+					if (it == val.end()) {
+						emplace_back(val);
+						read_json(rd, val.back());
+						it = val.end();
 					}
-					else if (c == '*') {
-						take();
-						c = read();
-						do {
-							while (c != '*') {
-								if (c == 0) {
-									return;
-								}
-								take();
-								c = read();
-							}
-							take();
-							c = read();
-							if (c == '/') {
-								take();
-								do_next = true;
-								break;
-							}
-						} while (true);
+					else {
+						read_json(rd, *it);
+						++it;
+					}
+					if (rd.failed()) {
+						rd.push_path(index);
+						return;
+					}
+					++index;
+					if (detail::is_ctrl(rd.peek(), ',')) {
+						rd.next();
+					}
+					else if (!detail::is_ctrl(rd.peek(), ']')) {
+						rd.error(errc::invalid_array, "no valid array!");
+						return;
 					}
-					//error parser comment
-					error("not a comment!");
 				}
-				case '"': {
-					cur_tok_.type = token::t_string;
-					parser_quote_string();
-					break;
+				val.erase(it, val.end());
+			}
+
+			template<typename T>
+			std::enable_if_t<is_template_instant_of<std::queue, T>::value> overwrite_elements(reader_t &rd, T &val) {
+				while (!val.empty())
+					val.pop();
+				read_elements(rd, val, 0, std::false_type{});
+			}
+
+			//numbers are read straight into storage sized once for the whole array
+			template<typename T>
+			void read_elements(reader_t &rd, T &val, size_t count, std::true_type) {
+				if (count == 0) {
+					if (rd.reuse())
+						val.clear();
+					read_elements(rd, val, count, std::false_type{});
+					return;
 				}
-				default: {
-					if (c >= '0' && c <= '9') {
-						cur_tok_.type = token::t_uint;
-						cur_tok_.value.u64 = c - '0';
-						parser_number();
+				size_t base = rd.reuse() ? 0 : val.size();
+				val.resize(base + count);
+				size_t index = 0;
+				while (!detail::is_ctrl(rd.peek(), ']')) {
+					if (index == count)
+						val.resize(base + ++count);
+					size_t run = rd.read_numbers(&val[base + index], count - index);
+					if (run != 0 && rd.failed()) {
+						//in the token after the last number
+						val.resize(base + index + run);
+						rd.push_path(index + run - 1);
+						return;
 					}
-					else if (c == '-') {
-						cur_tok_.type = token::t_int;
-						cur_tok_.value.u64 = '0' - c;
-						parser_number();
+					if (run == 0) {
+						read_json(rd, val[base + index]);
+						if (rd.failed()) {
+							val.resize(base + index + 1);
+							rd.push_path(index);
+							return;
+						}
+						run = 1;
 					}
-					else {
-						cur_tok_.type = token::t_string;
-						parser_string();
+					index += run;
+					if (detail::is_ctrl(rd.peek(), ',')) {
+						rd.next();
+					}
+					else if (!detail::is_ctrl(rd.peek(), ']')) {
+						val.resize(base + index);
+						rd.error(errc::invalid_array, "no valid array!");
+						return;
 					}
 				}
-				}
-				if (do_next == false)
+				val.resize(base + index);
+			}
+		}
+
+		template<typename T>
+		std::enable_if_t<is_sequence_container<T>::value> read_json(reader_t &rd, T &val) {
+			if (!detail::is_ctrl(rd.peek(), '[')) {
+				rd.error(errc::expected_array, "array must start with [.");
+				return;
+			}
+			if (val.empty())
+				iguana::detail::adopt_current_arena(val);
+			size_t count = detail::reserve_elements(rd, val);
+			rd.next();
+			if (rd.reuse() && !detail::is_number_vector<T>::value)
+				detail::overwrite_elements(rd, val);
+			else
+				detail::read_elements(rd, val, count, detail::is_number_vector<T>{});
+			if (rd.failed())
+				return;
+			rd.next();
+		}
+
+		namespace detail {
+			//keys and values of std::pmr maps are built with the map's memory resource
+			template<typename V, typename A>
+			std::enable_if_t<std::uses_allocator<V, A>::value, V> make_element(const A &a) {
+				return V(a);
+			}
+
+			template<typename V, typename A>
+			std::enable_if_t<!std::uses_allocator<V, A>::value, V> make_element(const A &) {
+				return V();
+			}
+
+			//ordered containers take keys in the order to_json writes them at the end in
+			//constant time, other orders cost a lookup. a repeated key replaces the value
+			template<typename T>
+			std::enable_if_t<is_ordered_container<T>::value && !is_multi_container<T>::value> insert_pair(T &val, typename T::key_type &&key, typename T::mapped_type &&value) {
+				if (val.empty() || val.key_comp()(std::prev(val.end())->first, key)) {
+					val.emplace_hint(val.end(), std::move(key), std::move(value));
 					return;
-				next();
+				}
+				auto it = val.lower_bound(key);
+				if (it != val.end() && !val.key_comp()(key, it->first))
+					it->second = std::move(value);
+				else
+					val.emplace_hint(it, std::move(key), std::move(value));
 			}
 
-			inline bool expect(char c) {
-				return cur_tok_.str.str[0] == c;
+			template<typename T>
+			std::enable_if_t<!is_ordered_container<T>::value && !is_multi_container<T>::value> insert_pair(T &val, typename T::key_type &&key, typename T::mapped_type &&value) {
+#ifdef __cpp_lib_map_try_emplace
+				auto r = val.try_emplace(std::move(key), std::move(value));
+				if (!r.second)
+					r.first->second = std::move(value);
+#else
+				val[std::move(key)] = std::move(value);
+#endif
 			}
 
-		private:
-			inline void decimal_reset() { decimal = 0.1; }
+			//repeated keys are all kept, in the order they come
+			template<typename T>
+			std::enable_if_t<is_ordered_container<T>::value && is_multi_container<T>::value> insert_pair(T &val, typename T::key_type &&key, typename T::mapped_type &&value) {
+				val.emplace_hint(val.end(), std::move(key), std::move(value));
+			}
 
-			inline char read() const {
-				if (end_mark_)
-					return 0;
-				return ptr_[cur_offset_];
+			template<typename T>
+			std::enable_if_t<!is_ordered_container<T>::value && is_multi_container<T>::value> insert_pair(T &val, typename T::key_type &&key, typename T::mapped_type &&value) {
+				val.emplace(std::move(key), std::move(value));
 			}
 
-			inline void take() {
-				if (end_mark_ == false) {
-					++cur_offset_;
-					char v = ptr_[cur_offset_];
-					if (v != '\r')
-						++cur_col_;
-					if (len_ > 0 && cur_offset_ >= len_) {
-						end_mark_ = true;
-					}
-					else if (v == 0) {
-						end_mark_ = true;
-					}
-					if (v == '\n') {
-						cur_col_ = 0;
-						++cur_line_;
-					}
+			template<typename T>
+			std::enable_if_t<is_ordered_container<T>::value> insert_key(T &val, typename T::key_type &&key) {
+				val.emplace_hint(val.end(), std::move(key));
+			}
+
+			template<typename T>
+			std::enable_if_t<!is_ordered_container<T>::value> insert_key(T &val, typename T::key_type &&key) {
+				val.emplace(std::move(key));
+			}
+
+			//map keys in error paths
+			template<typename K>
+			std::enable_if_t<is_char_string<K>::value> push_key(reader_t &rd, const K &key) {
+				rd.push_path(key.data(), key.size());
+			}
+
+			template<typename K>
+			std::enable_if_t<std::is_arithmetic<K>::value> push_key(reader_t &rd, K key) {
+				std::string s = std::to_string(key);
+				rd.push_path(s.data(), s.size());
+			}
+
+			template<typename K>
+			std::enable_if_t<is_string_view<K>::value> push_key(reader_t &rd, const K &key) {
+				rd.push_path(key.data(), key.size());
+			}
+
+			//"key": value into key and value, which are left partly read on failure
+			template<typename K, typename V>
+			bool read_pair(reader_t &rd, K &key, V &value) {
+				read_json(rd, key);
+				if (!detail::is_ctrl(rd.peek(), ':')) {
+					rd.error(errc::invalid_object, "invalid object!");
+					return false;
+				}
+				rd.next();
+				read_json(rd, value);
+				if (rd.failed()) {
+					detail::push_key(rd, key);
+					return false;
 				}
+				return true;
 			}
 
-			char skip() {
-				auto c = read();
-				while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-					take();
-					c = read();
+#ifdef __cpp_lib_node_extract
+			//the entries of maps and sets being read in reuse mode are taken out and read
+			//over, so reading the same shape again allocates nothing. one stack per
+			//thread and type, as nested containers of the same type share it
+			template<typename T>
+			std::vector<typename T::node_type> &node_pool() {
+				static thread_local std::vector<typename T::node_type> pool;
+				return pool;
+			}
+
+			template<typename T>
+			class recycled_nodes {
+			public:
+				recycled_nodes(reader_t &rd, T &val) : pool_(node_pool<T>()), base_(pool_.size()) {
+					if (rd.reuse()) {
+						while (!val.empty())
+							pool_.push_back(val.extract(val.begin()));
+					}
+				}
+
+				recycled_nodes(const recycled_nodes&) = delete;
+				recycled_nodes& operator=(const recycled_nodes&) = delete;
+
+				//the ones not read over are freed
+				~recycled_nodes() {
+					pool_.erase(pool_.begin() + base_, pool_.end());
+				}
+
+				inline bool empty() const {
+					return pool_.size() == base_;
+				}
+
+				typename T::node_type take() {
+					typename T::node_type node = std::move(pool_.back());
+					pool_.pop_back();
+					return node;
+				}
+
+			private:
+				std::vector<typename T::node_type> &pool_;
+				size_t base_;
+			};
+
+			//the same as insert_pair and insert_key, for taken out entries
+			template<typename T>
+			std::enable_if_t<is_ordered_container<T>::value && !is_multi_container<T>::value> insert_node(T &val, typename T::node_type &&node, std::true_type) {
+				if (val.empty() || val.key_comp()(std::prev(val.end())->first, node.key())) {
+					val.insert(val.end(), std::move(node));
+					return;
 				}
-				return c;
+				auto it = val.lower_bound(node.key());
+				if (it != val.end() && !val.key_comp()(node.key(), it->first))
+					it->second = std::move(node.mapped());
+				else
+					val.insert(it, std::move(node));
 			}
 
-			inline void fill_escape_char(size_t count, char c) {
-				//            if (count == 0)
-				//                return;
-				//
-				//           ptr_[cur_offset_ - count] = c;
+			template<typename T>
+			std::enable_if_t<!is_ordered_container<T>::value && !is_multi_container<T>::value> insert_node(T &val, typename T::node_type &&node, std::true_type) {
+				auto r = val.insert(std::move(node));
+				if (!r.inserted)
+					r.position->second = std::move(r.node.mapped());
 			}
 
-			char table[103] = {
-					16, 16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 16, 17, 17, 16,
-					16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
-					16, 16, 17, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
-					16, 16, 16, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 16, 16, 16, 16, 16,
-					16, 16, 10, 11, 12, 13, 14, 15, 16, 16, 16, 16, 16, 16, 16, 16,
-					16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
-					16, 16, 10, 11, 12, 13, 14, 15 };
+			template<typename T, typename IsMap>
+			std::enable_if_t<is_ordered_container<T>::value && (is_multi_container<T>::value || !IsMap::value)> insert_node(T &val, typename T::node_type &&node, IsMap) {
+				val.insert(val.end(), std::move(node));
+			}
 
-			inline char char_to_hex(char v) {
-				if (v < 'f') {
-					v = table[v];
+			template<typename T, typename IsMap>
+			std::enable_if_t<!is_ordered_container<T>::value && (is_multi_container<T>::value || !IsMap::value)> insert_node(T &val, typename T::node_type &&node, IsMap) {
+				val.insert(std::move(node));
+			}
+#else
+			//without node handles reuse mode can only keep the buckets of unordered ones
+			template<typename T>
+			class recycled_nodes {
+			public:
+				recycled_nodes(reader_t &rd, T &val) {
+					if (rd.reuse())
+						val.clear();
 				}
-				else {
-					v = 16;
+			};
+#endif
+		}
+
+		template<typename T>
+		std::enable_if_t<is_associat_container<T>::value> read_json(reader_t &rd, T &val) {
+			if (!detail::is_ctrl(rd.peek(), '{'))
+			{
+				rd.error(errc::expected_object, "object must start with {!");
+				return;
+			}
+			rd.next();
+			if (val.empty())
+				iguana::detail::adopt_current_arena(val);
+			detail::recycled_nodes<T> nodes(rd, val);
+			while (!detail::is_ctrl(rd.peek(), '}'))
+			{
+#ifdef __cpp_lib_node_extract
+				if (!nodes.empty())
+				{
+					auto node = nodes.take();
+					if (!detail::read_pair(rd, node.key(), node.mapped()))
+						return;
+					detail::insert_node(val, std::move(node), std::true_type{});
 				}
-				if (v > 15)
-					error("utf8 code error!");
-				return v;
+				else
+#endif
+				{
+					auto key = detail::make_element<typename T::key_type>(val.get_allocator());
+					auto value = detail::make_element<typename T::mapped_type>(val.get_allocator());
+					if (!detail::read_pair(rd, key, value))
+						return;
+					detail::insert_pair(val, std::move(key), std::move(value));
+				}
+				if (detail::is_ctrl(rd.peek(), ','))
+				{
+					rd.next();
+				}
+				else if (!detail::is_ctrl(rd.peek(), '}'))
+				{
+					rd.error(errc::invalid_object, "no valid object!");
+					return;
+				}
+			}
+			rd.next();
+		}
+
+		template<typename T>
+		std::enable_if_t<is_set_container<T>::value> read_json(reader_t &rd, T &val) {
+			if (!detail::is_ctrl(rd.peek(), '[')) {
+				rd.error(errc::expected_array, "array must start with [.");
+				return;
+			}
+			rd.next();
+			if (val.empty())
+				iguana::detail::adopt_current_arena(val);
+			detail::recycled_nodes<T> nodes(rd, val);
+			size_t index = 0;
+			while (!detail::is_ctrl(rd.peek(), ']')) {
+#ifdef __cpp_lib_node_extract
+				if (!nodes.empty()) {
+					auto node = nodes.take();
+					read_json(rd, node.value());
+					if (rd.failed()) {
+						rd.push_path(index);
+						return;
+					}
+					detail::insert_node(val, std::move(node), std::false_type{});
+				}
+				else
+#endif
+				{
+					auto key = detail::make_element<typename T::key_type>(val.get_allocator());
+					read_json(rd, key);
+					if (rd.failed()) {
+						rd.push_path(index);
+						return;
+					}
+					detail::insert_key(val, std::move(key));
+				}
+				++index;
+				if (detail::is_ctrl(rd.peek(), ',')) {
+					rd.next();
+				}
+				else if (!detail::is_ctrl(rd.peek(), ']')) {
+					rd.error(errc::invalid_array, "no valid array!");
+					return;
+				}
+			}
+			rd.next();
+		}
+
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void do_read(reader_t &rd, T &&t);
+
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void read_json(reader_t &rd, T &val) {
+			do_read(rd, val);
+		}
+
+		namespace detail {
+			//fnv-1a, the only pass over the bytes of a key
+			constexpr uint64_t hash_key(const char *data, size_t size) {
+				uint64_t h = 14695981039346656037ull;
+				for (size_t i = 0; i < size; ++i) {
+					h ^= static_cast<unsigned char>(data[i]);
+					h *= 1099511628211ull;
+				}
+				return h;
+			}
+
+			constexpr uint64_t mix_key(uint64_t h, uint64_t seed) {
+				h ^= seed * 0x9E3779B97F4A7C15ull;
+				h ^= h >> 33;
+				h *= 0xff51afd7ed558ccdull;
+				h ^= h >> 33;
+				return h;
 			}
 
-			inline uint64_t read_utf() {
-				char v = char_to_hex(read());
-				uint64_t utf = v;
-				utf <<= 4;
-				take();
-				v = char_to_hex(read());
-				utf += v;
-				utf <<= 4;
-				take();
-				v = char_to_hex(read());
-				utf += v;
-				utf <<= 4;
-				take();
-				v = char_to_hex(read());
-				utf += v;
-				take();
-				return utf;
+			constexpr size_t ceil_pow2(size_t n) {
+				size_t p = 1;
+				while (p < n)
+					p <<= 1;
+				return p;
 			}
 
-			inline void esacpe_utf8(size_t &esc_count) {
-				uint64_t utf1 = read_utf();
-				esc_count += 6;
+			//perfect hash over the member names built by hash and displace: the bucket of
+			//a key picks a seed that sends it to a slot no other member uses
+			template<size_t N>
+			struct member_table {
+				static constexpr size_t bucket_count = ceil_pow2(N);
+				static constexpr size_t slot_count = ceil_pow2(N * 2);
 
-				if (utf1 < 0x80) {
-					fill_escape_char(esc_count, (char)utf1);
-				}
-				else if (utf1 < 0x800) {
-					fill_escape_char(esc_count, (char)(0xC0 | ((utf1 >> 6) & 0xFF)));
-					fill_escape_char(esc_count - 1, (char)(0x80 | ((utf1 & 0x3F))));
+				uint32_t seeds[bucket_count];
+				uint8_t slots[slot_count]; //member index + 1, 0 for empty slots
+				bool perfect;
+
+				constexpr size_t bucket(uint64_t h) const {
+					return (h ^ (h >> 32)) & (bucket_count - 1);
 				}
-				else if (utf1 < 0x80000) {
-					fill_escape_char(esc_count, (char)(0xE0 | ((utf1 >> 12) & 0xFF)));
-					fill_escape_char(esc_count - 1, (char)(0x80 | ((utf1 >> 6) & 0x3F)));
-					fill_escape_char(esc_count - 2, (char)(0x80 | ((utf1 & 0x3F))));
+
+				constexpr size_t slot(uint64_t h) const {
+					return mix_key(h, seeds[bucket(h)]) & (slot_count - 1);
 				}
-				else {
-					if (utf1 < 0x110000) {
-						error("utf8 code error!");
-					}
-					fill_escape_char(esc_count, (char)(0xF0 | ((utf1 >> 18) & 0xFF)));
-					fill_escape_char(esc_count - 1, (char)(0x80 | ((utf1 >> 12) & 0x3F)));
-					fill_escape_char(esc_count - 2, (char)(0x80 | ((utf1 >> 6) & 0x3F)));
-					fill_escape_char(esc_count - 3, (char)(0x80 | ((utf1 & 0x3F))));
+			};
+
+			template<typename T>
+			constexpr member_table<Members<T>::value> make_member_table() {
+				using M = Members<T>;
+				constexpr size_t N = M::value;
+				constexpr size_t bucket_count = member_table<N>::bucket_count;
+				member_table<N> table{};
+				table.perfect = true;
+
+				uint64_t hashes[N] = {};
+				size_t sizes[bucket_count] = {};
+				for (size_t i = 0; i < N; ++i) {
+					hashes[i] = hash_key(M::json_keys[i].data + 1, M::json_keys[i].size - 3);
+					++sizes[table.bucket(hashes[i])];
 				}
-			}
 
-			void parser_quote_string() {
-				take();
-				cur_tok_.str.str = ptr_ + cur_offset_;
-				auto c = read();
-				size_t esc_count = 0;
-				do {
-					switch (c) {
-					case 0:
-					case '\n': {
-						error("not a valid quote string!");
-						break;
-					}
-					case '\\': {
-						take();
-						c = read();
-						switch (c) {
-						case 'b': {
-							c = '\b';
-							break;
-						}
-						case 'f': {
-							c = '\f';
-							break;
-						}
-						case 'n': {
-							c = '\n';
-							break;
-						}
-						case 'r': {
-							c = '\r';
-							break;
-						}
-						case 't': {
-							c = '\t';
-							break;
-						}
-						case '"': {
-							break;
-						}
-						case 'u': {
-							take();
-							esacpe_utf8(esc_count);
+				//the fullest buckets go first while most slots are still free
+				for (size_t size = N; size > 0; --size) {
+					for (size_t b = 0; b < bucket_count; ++b) {
+						if (sizes[b] != size)
 							continue;
+
+						bool placed = false;
+						for (uint32_t seed = 0; seed < 0x10000 && !placed; ++seed) {
+							table.seeds[b] = seed;
+							placed = true;
+							size_t taken[N] = {};
+							size_t count = 0;
+							for (size_t i = 0; i < N && placed; ++i) {
+								if (table.bucket(hashes[i]) != b)
+									continue;
+								size_t s = table.slot(hashes[i]);
+								if (table.slots[s] != 0)
+									placed = false;
+								for (size_t k = 0; k < count; ++k) {
+									if (taken[k] == s)
+										placed = false;
+								}
+								taken[count++] = s;
+							}
 						}
-						default: {
-							error("unknown escape char!");
+						if (!placed) {
+							table.perfect = false;
+							return table;
 						}
+
+						for (size_t i = 0; i < N; ++i) {
+							if (table.bucket(hashes[i]) == b)
+								table.slots[table.slot(hashes[i])] = static_cast<uint8_t>(i + 1);
 						}
-						++esc_count;
-						break;
-					}
-					case '"': {
-						cur_tok_.str.len = ptr_ + cur_offset_ - esc_count - cur_tok_.str.str;
-						take();
-						return;
 					}
-					}
-					fill_escape_char(esc_count, c);
-					take();
-					c = read();
-				} while (true);
+				}
+				return table;
 			}
 
-			void parser_string() {
-				cur_tok_.str.str = ptr_ + cur_offset_;
-				take();
-				auto c = read();
-				size_t esc_count = 0;
-				do {
-					switch (c) {
-					case 0:
-					case '\n': {
-						error("not a valid string!");
-						break;
-					}
-					case '\\': {
-						take();
-						c = read();
-						switch (c) {
-						case 'b': {
-							c = '\b';
-							break;
-						}
-						case 'f': {
-							c = '\f';
-							break;
-						}
-						case 'n': {
-							c = '\n';
-							break;
-						}
-						case 'r': {
-							c = '\r';
-							break;
-						}
-						case 't': {
-							c = '\t';
-							break;
-						}
-						case 'u': {
-							take();
-							esacpe_utf8(esc_count);
-							continue;
-						}
-						default: {
-							error("unknown escape char!");
-						}
-						}
-						++esc_count;
-						break;
-					}
-					case ' ':
-					case '\t':
-					case '\r':
-					case ',':
-					case '[':
-					case ']':
-					case ':':
-					case '{':
-					case '}': {
-						cur_tok_.str.len = ptr_ + cur_offset_ - esc_count - cur_tok_.str.str;
-						return;
-					}
-					}
-					fill_escape_char(esc_count, c);
-					take();
-					c = read();
-				} while (true);
+			template<typename T>
+			struct member_lookup {
+				static constexpr member_table<Members<T>::value> table = make_member_table<T>();
+				static_assert(table.perfect, "no perfect hash found for the member names");
+			};
+
+			template<typename T>
+			constexpr member_table<Members<T>::value> member_lookup<T>::table;
+
+			//whether key is the name of member i, compared against the "name": fragment
+			template<typename T>
+			inline bool is_member(size_t i, const char *key, size_t size) {
+				const name_fragment &name = Members<T>::json_keys[i];
+				return name.size - 3 == size && memcmp(name.data + 1, key, size) == 0;
 			}
 
-			void parser_number() {
-				cur_tok_.str.str = ptr_ + cur_offset_;
-				take();
-				auto c = read();
-				do {
-					switch (c) {
-					case '0':
-					case '1':
-					case '2':
-					case '3':
-					case '4':
-					case '5':
-					case '6':
-					case '7':
-					case '8':
-					case '9': {
-						if (cur_tok_.type == token::t_int) {
-							cur_tok_.value.i64 *= 10;
-							cur_tok_.value.i64 += c - '0';
-						}
-						else if (cur_tok_.type == token::t_uint) {
-							cur_tok_.value.u64 *= 10;
-							cur_tok_.value.u64 += c - '0';
-						}
-						else if (cur_tok_.type == token::t_number) {
-							cur_tok_.value.d64 += decimal * (c - '0');
-							decimal *= 0.1;
-						}
-						break;
-					}
-					case '.': {
-						if (cur_tok_.type == token::t_int) {
-							cur_tok_.type = token::t_number;
-							cur_tok_.value.d64 = (double)cur_tok_.value.i64;
-							decimal_reset();
-						}
-						else if (cur_tok_.type == token::t_uint) {
-							cur_tok_.type = token::t_number;
-							cur_tok_.value.d64 = (double)cur_tok_.value.u64;
-							decimal_reset();
-						}
-						else if (cur_tok_.type == token::t_number) {
-							error("not a valid number!");
-						}
-						break;
-					}
-					default: {
-						cur_tok_.str.len = ptr_ + cur_offset_ - cur_tok_.str.str;
-						return;
-					}
-					}
-					take();
-					c = read();
-				} while (1);
+			//index of the member named key, Members<T>::value if there is none
+			template<typename T>
+			size_t find_member(const char *key, size_t size) {
+				const auto &table = member_lookup<T>::table;
+				size_t i = table.slots[table.slot(hash_key(key, size))];
+				if (i == 0 || !is_member<T>(i - 1, key, size))
+					return Members<T>::value;
+				return i - 1;
 			}
 
-			token cur_tok_;
-			size_t cur_col_ = 0;
-			size_t cur_line_ = 0;
-			size_t len_ = 0;
-			size_t cur_offset_ = 0;
-			bool end_mark_ = false;
-			const char *ptr_;
-			double decimal = 0.1;
-		};
+			//keys usually come in declaration order, so the member after the last one
+			//read is tried with a single compare before hashing
+			template<typename T>
+			inline size_t find_member(size_t expected, const char *key, size_t size) {
+				if (expected < Members<T>::value && is_member<T>(expected, key, size))
+					return expected;
+				return find_member<T>(key, size);
+			}
 
-		void skip(reader_t &rd);
+			template<typename T, size_t I>
+			void read_member(reader_t &rd, T &t) {
+				read_json(rd, t.*std::get<I>(Members<T>::apply()));
+			}
 
-		inline void skip_array(reader_t &rd) {
-			auto tok = &rd.peek();
-			while (tok->str.str[0] != ']') {
-				skip(rd);
-				tok = &rd.peek();
-				if (tok->str.str[0] == ',') {
-					rd.next();
-					tok = &rd.peek();
-					continue;
-				}
+			template<typename T, size_t... Is>
+			void dispatch_member(reader_t &rd, T &t, size_t index, std::index_sequence<Is...>) {
+				using reader_fn = void(*)(reader_t&, T&);
+				static constexpr reader_fn readers[] = { &read_member<T, Is>... };
+				readers[index](rd, t);
 			}
-			rd.next();
-		}
 
-		inline void skip_key(reader_t &rd) {
-			auto &tok = rd.peek();
-			switch (tok.type) {
-			case token::t_string:
-			case token::t_int:
-			case token::t_uint:
-			case token::t_number: {
-				rd.next();
-				return;
+			//what a fresh object holds, for resetting members a document left out in
+			//reuse mode. built outside any arena_scope, as it is copied from later
+			template<typename T>
+			const T &default_value() {
+				arena *&current = iguana::detail::current_arena();
+				arena *prev = current;
+				current = nullptr;
+				static const T value{};
+				current = prev;
+				return value;
 			}
-			default:
-				break;
+
+			//assigning keeps the storage of strings and containers
+			template<typename T>
+			void assign_default(T &val, const T &def) {
+				val = def;
 			}
-			rd.error("invalid json document!");
-		}
 
-		inline void skip_object(reader_t &rd) {
-			auto tok = &rd.peek();
-			while (tok->str.str[0] != '}') {
-				skip_key(rd);
-				tok = &rd.peek();
-				if (tok->str.str[0] == ':') {
-					rd.next();
-					skip(rd);
-					tok = &rd.peek();
-				}
-				else {
-					rd.error("invalid json document!");
-				}
-				if (tok->str.str[0] == ',') {
-					rd.next();
-					tok = &rd.peek();
-					continue;
-				}
+			template<typename T, size_t N>
+			void assign_default(T(&val)[N], const T(&def)[N]) {
+				std::copy(def, def + N, val);
+			}
+
+			template<typename T, size_t N, size_t... Is>
+			void reset_missing(T &t, const std::bitset<N> &seen, std::index_sequence<Is...>) {
+				const T &def = default_value<T>();
+				int expand[] = { (seen[Is] ? 0 : (assign_default(t.*std::get<Is>(Members<T>::apply()), def.*std::get<Is>(Members<T>::apply())), 0))..., 0 };
+				(void)expand;
 			}
-			rd.next();
 		}
 
-		inline void skip(reader_t &rd) {
-			auto &tok = rd.peek();
-			switch (tok.type) {
-			case token::t_string:
-			case token::t_int:
-			case token::t_uint:
-			case token::t_number: {
-				rd.next();
+		//reads a whole object; members may come in any order and unknown keys are skipped
+		template<typename T, typename>
+		void do_read(reader_t &rd, T &&t) {
+			using U = std::remove_reference_t<T>;
+			using M = Members<U>;
+			if (!detail::is_ctrl(rd.peek(), '{')) {
+				rd.error(errc::expected_object, "object must start with {!");
 				return;
 			}
-			case token::t_ctrl: {
-				if (tok.str.str[0] == '[') {
-					rd.next();
-					skip_array(rd);
+			rd.next();
+
+			//in reuse mode the members not in the document are reset afterwards
+			std::bitset<M::value> seen;
+			size_t expected = 0;
+			while (!detail::is_ctrl(rd.peek(), '}')) {
+				auto &tok = rd.peek();
+				if (tok.type != token::t_string) {
+					rd.error(errc::invalid_object, "invalid object key!");
 					return;
 				}
-				else if (tok.str.str[0] == '{') {
+				size_t index = detail::find_member<U>(expected, tok.str.str, tok.str.len);
+				expected = index + 1;
+				rd.next();
+				if (!detail::is_ctrl(rd.peek(), ':')) {
+					rd.error(errc::invalid_object, "invalid object!");
+					return;
+				}
+				rd.next();
+
+				if (index == M::value) {
+					skip(rd);
+				}
+				else {
+					if (rd.reuse())
+						seen.set(index);
+					detail::dispatch_member(rd, t, index, std::make_index_sequence<M::value>{});
+					if (rd.failed()) {
+						const name_fragment &name = M::json_keys[index];
+						rd.push_path(name.data + 1, name.size - 3);
+						return;
+					}
+				}
+
+				if (detail::is_ctrl(rd.peek(), ',')) {
 					rd.next();
-					skip_object(rd);
+				}
+				else if (!detail::is_ctrl(rd.peek(), '}')) {
+					rd.error(errc::invalid_object, "no valid object!");
 					return;
 				}
 			}
-			case token::t_end: {
-				return;
-			}
-			}
-			rd.error("invalid json document!");
+			if (rd.reuse() && !seen.all())
+				detail::reset_missing(t, seen, std::make_index_sequence<M::value>{});
+			rd.next();
 		}
 
-		//read json to value
-		template<typename T>
-		std::enable_if_t<is_signed_intergral_like<T>::value> read_json(reader_t &rd, T &val) {
-			auto &tok = rd.peek();
-			switch (tok.type) {
-			case token::t_string: {
-				int64_t temp = std::strtoll(tok.str.str, nullptr, 10);
-				val = static_cast<int>(temp);
-				break;
-			}
-			case token::t_int: {
-				val = static_cast<int>(tok.value.i64);
-				break;
-			}
-			case token::t_uint: {
-				val = static_cast<int>(tok.value.u64);
-				break;
-			}
-			case token::t_number: {
-				val = static_cast<int>(tok.value.d64);
-				break;
-			}
-			default: {
-				rd.error("not a valid signed integral like number.");
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void from_json(T &&t, const char *buf, size_t len = -1) {
+			reader_t rd(buf, len);
+			do_read(rd, t);
+		}
+
+		//decodes escaped strings in place, so buf is modified; string views in t
+		//always point into buf
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void from_json_insitu(T &&t, char *buf, size_t len = -1) {
+			reader_t rd(buf, len, true);
+			do_read(rd, t);
+		}
+
+		//never throws; the error converts to true if t could not be read, and t is
+		//then left partly filled
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		parse_error from_json(T &&t, const char *buf, size_t len, const std::nothrow_t&) {
+			reader_t rd(buf, len, std::nothrow);
+			do_read(rd, t);
+			return rd.get_error();
+		}
+
+		//for decoding many documents into the same object: containers are read over
+		//instead of appended to, keeping their storage and their elements' storage,
+		//so once t has grown to the size of the documents reading allocates nothing.
+		//t ends up as from_json would leave a fresh object, members missing from buf
+		//are reset to their default value
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void from_json_reuse(T &&t, const char *buf, size_t len = -1) {
+			reader_t rd(buf, len);
+			rd.set_reuse(true);
+			do_read(rd, t);
+		}
+
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		parse_error from_json_reuse(T &&t, const char *buf, size_t len, const std::nothrow_t&) {
+			reader_t rd(buf, len, std::nothrow);
+			rd.set_reuse(true);
+			do_read(rd, t);
+			return rd.get_error();
+		}
+
+		//string views in t point into buf, or into a if they had escapes. strings and
+		//containers using arena_allocator are allocated from a as well
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void from_json(T &&t, const char *buf, size_t len, arena &a) {
+			arena_scope scope(a);
+			reader_t rd(buf, len);
+			rd.use_arena(a);
+			do_read(rd, t);
+		}
+
+		///*********************************** ndjson *********************************///
+		//one object per line, each followed by '\n'
+		template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void to_ndjson(Stream& s, const std::vector<T> &v) {
+			for (auto &item : v) {
+				to_json(s, item);
+				s.put('\n');
 			}
+		}
+
+		//a line that failed to parse, lines count from 1
+		struct ndjson_error {
+			size_t line;
+			std::string message;
+		};
+
+		namespace detail {
+			inline const char* find_newline(const char* p, const char* end) {
+#ifdef IGUANA_USE_AVX2
+				const __m256i nl32 = _mm256_set1_epi8('\n');
+				for (; end - p >= 32; p += 32) {
+					const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl32)));
+					if (mask != 0)
+						return p + count_trailing_zeros(mask);
+				}
+#endif
+#ifdef IGUANA_USE_SSE2
+				const __m128i nl = _mm_set1_epi8('\n');
+				for (; end - p >= 16; p += 16) {
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+					const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+					if (mask != 0)
+						return p + count_trailing_zeros(mask);
+				}
+#endif
+				for (; p < end; ++p) {
+					if (*p == '\n')
+						return p;
+				}
+				return end;
 			}
-			rd.next();
-		}
 
-		template<typename T>
-		inline std::enable_if_t<is_unsigned_intergral_like<T>::value> read_json(reader_t &rd, T &val) {
-			auto &tok = rd.peek();
-			switch (tok.type) {
-			case token::t_string: {
-				uint64_t temp = std::strtoull(tok.str.str, nullptr, 10);
-				val = static_cast<unsigned int>(temp);
-				break;
+			inline bool is_blank(char c) {
+				return c == ' ' || c == '\t' || c == '\r';
 			}
-			case token::t_int: {
-				if (tok.value.i64 < 0) {
-					rd.error("assign a negative signed integral to unsigned integral number.");
+
+			struct ndjson_line {
+				const char *data;
+				size_t size;
+				size_t number;
+			};
+
+			//appends up to max non blank lines starting at p, trimmed, and returns
+			//where it stopped; number is the count of lines seen so far
+			inline const char* split_lines(const char *p, const char *end, size_t &number, size_t max, std::vector<ndjson_line> &lines) {
+				while (p != end && lines.size() < max) {
+					const char *nl = find_newline(p, end);
+					const char *last = nl;
+					++number;
+					while (p != last && is_blank(*p))
+						++p;
+					while (last != p && is_blank(last[-1]))
+						--last;
+					if (p != last)
+						lines.push_back(ndjson_line{ p, size_t(last - p), number });
+					p = nl == end ? end : nl + 1;
 				}
-				val = static_cast<unsigned int>(tok.value.i64);
-				break;
-			}
-			case token::t_uint: {
-				val = static_cast<unsigned int>(tok.value.u64);
-				break;
+				return p;
 			}
-			case token::t_number: {
-				if (tok.value.d64 < 0) {
-					rd.error("assign a negative float point to unsigned integral number.");
+
+			//parses lines[i] into out[i], leaving the reason in errors[i] if it fails
+			template<typename T>
+			void parse_lines(const ndjson_line *lines, size_t count, T *out, std::string *errors) {
+				for (size_t i = 0; i < count; ++i) {
+					reader_t rd(lines[i].data, lines[i].size, std::nothrow);
+					do_read(rd, out[i]);
+					if (rd.failed())
+						errors[i] = rd.describe_error();
 				}
-				val = static_cast<unsigned int>(tok.value.d64);
-				break;
 			}
-			default: {
-				rd.error("not a valid unsigned integral like number.");
+
+			//as parse_lines, split into chunks of at least min_chunk lines on up to
+			//threads threads (0 for one per core)
+			template<typename T>
+			void parse_lines_parallel(const ndjson_line *lines, size_t count, T *out, std::string *errors, size_t threads, size_t min_chunk = 256) {
+				if (threads == 0)
+					threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+				size_t chunks = (std::min)(threads, count / min_chunk);
+				if (chunks < 2) {
+					parse_lines(lines, count, out, errors);
+					return;
+				}
+
+				std::vector<std::future<void>> parts;
+				parts.reserve(chunks);
+				size_t step = count / chunks, rest = count % chunks, first = 0;
+				for (size_t i = 0; i < chunks; ++i) {
+					size_t n = step + (i < rest ? 1 : 0);
+					parts.push_back(std::async(std::launch::async, [=] {
+						parse_lines(lines + first, n, out + first, errors + first);
+					}));
+					first += n;
+				}
+				for (auto &part : parts)
+					part.get();
 			}
+
+			//the failed lines go to errors, or the first one is thrown if there is no errors
+			inline bool report_lines(const ndjson_line *lines, std::string *messages, size_t count, std::vector<ndjson_error> *errors) {
+				bool failed = false;
+				for (size_t i = 0; i < count; ++i) {
+					if (messages[i].empty())
+						continue;
+					if (errors == nullptr)
+						iguana::detail::throw_invalid_argument("ndjson line " + std::to_string(lines[i].number) + ": " + messages[i]);
+					//copied, the caller still tells failed lines by their message
+					errors->push_back(ndjson_error{ lines[i].number, messages[i] });
+					failed = true;
+				}
+				return failed;
 			}
-			rd.next();
 		}
 
-		template<typename T>
-		inline std::enable_if_t<std::is_enum<T>::value> read_json(reader_t &rd, T &val) {
-			typedef typename std::underlying_type<T>::type RAW_TYPE;
-			read_json(rd, (RAW_TYPE&)val);
+		//appends one object per non blank line to v, parsing on up to threads threads
+		//(0 for one per core); a malformed line throws std::invalid_argument and leaves
+		//v unchanged, unless errors is given, then it is skipped and reported there
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		void from_ndjson(std::vector<T> &v, const char *buf, size_t len, std::vector<ndjson_error> *errors = nullptr, size_t threads = 0) {
+			std::vector<detail::ndjson_line> lines;
+			size_t number = 0;
+			detail::split_lines(buf, buf + len, number, size_t(-1), lines);
+
+			std::vector<T> values(lines.size());
+			std::vector<std::string> messages(lines.size());
+			detail::parse_lines_parallel(lines.data(), lines.size(), values.data(), messages.data(), threads);
+			bool failed = detail::report_lines(lines.data(), messages.data(), lines.size(), errors);
+
+			v.reserve(v.size() + lines.size());
+			for (size_t i = 0; i < lines.size(); ++i) {
+				if (!failed || messages[i].empty())
+					v.push_back(std::move(values[i]));
+			}
 		}
 
-		template<typename T>
-		inline std::enable_if_t<std::is_floating_point<T>::value> read_json(reader_t &rd, T &val) {
-			auto& tok = rd.peek();
-			switch (tok.type)
-			{
-			case token::t_string:
-			{
-				double temp = std::strtold(tok.str.str, nullptr);
-				val = static_cast<T>(temp);
-				break;
-			}
-			case token::t_int:
-			{
-				val = static_cast<T>(tok.value.i64);
-				break;
-			}
-			case token::t_uint:
-			{
-				val = static_cast<T>(tok.value.u64);
-				break;
-			}
-			case token::t_number:
-			{
-				val = static_cast<T>(tok.value.d64);
-				break;
-			}
-			default:
-			{
-				rd.error("not a valid float point number.");
-			}
+		//calls f(T&&) for each line in order; lines are parsed batch_size at a time on up to
+		//threads threads, so memory stays bounded; a malformed line throws once the lines
+		//before it have been handed to f, unless errors is given
+		template<typename T, typename F, typename = std::enable_if_t<is_reflection<T>::value>>
+		void from_ndjson(const char *buf, size_t len, F f, std::vector<ndjson_error> *errors = nullptr, size_t threads = 0, size_t batch_size = 4096) {
+			const char *p = buf, *end = buf + len;
+			size_t number = 0;
+			std::vector<detail::ndjson_line> lines;
+			std::vector<T> values;
+			std::vector<std::string> messages;
+			while (p != end) {
+				lines.clear();
+				p = detail::split_lines(p, end, number, batch_size, lines);
+
+				values.clear();
+				values.resize(lines.size());
+				messages.assign(lines.size(), std::string());
+				detail::parse_lines_parallel(lines.data(), lines.size(), values.data(), messages.data(), threads);
+				for (size_t i = 0; i < lines.size(); ++i) {
+					if (messages[i].empty())
+						f(std::move(values[i]));
+					else
+						detail::report_lines(&lines[i], &messages[i], 1, errors);
+				}
 			}
-			rd.next();
 		}
 
-		inline void read_json(reader_t &rd, bool &val) {
-			auto& tok = rd.peek();
-			switch (tok.type)
-			{
-			case token::t_string:
-			{
-				char const * ptr = tok.str.str;
-				if (tok.str.len == 4)
-				{
-					val = (ptr[0] == 't' || ptr[0] == 'T') &&
-						(ptr[1] == 'r' || ptr[1] == 'R') &&
-						(ptr[2] == 'u' || ptr[2] == 'U') &&
-						(ptr[3] == 'e' || ptr[3] == 'E');
+		///*********************************** lazy view *********************************///
+		//one pass over an object records where each member's value is; a member is read
+		//into the view's own T the first time get<I>() asks for it. the object itself
+		//is checked up front, but nested arrays and objects of members are only bracket
+		//matched until they are read; value() accepts what from_json accepts. buf has
+		//to outlive the view, and errors in a member are reported with positions
+		//relative to the start of its value
+		template<typename T>
+		class view {
+			using M = Members<T>;
+			static constexpr size_t npos = size_t(-1);
+
+		public:
+			view(const char *buf, size_t len = -1) : buf_(buf), t_() {
+				for (size_t i = 0; i < M::value; ++i) {
+					begin_[i] = npos;
+					end_[i] = npos;
+					decoded_[i] = false;
 				}
-				else
-				{
-					val = false;
+
+				reader_t rd(buf, len);
+				if (!detail::is_ctrl(rd.peek(), '{'))
+					rd.error(errc::expected_object, "object must start with {!");
+				rd.next();
+
+				size_t expected = 0;
+				while (!detail::is_ctrl(rd.peek(), '}')) {
+					auto &tok = rd.peek();
+					if (tok.type != token::t_string)
+						rd.error(errc::invalid_object, "invalid object key!");
+					size_t index = detail::find_member<T>(expected, tok.str.str, tok.str.len);
+					expected = index + 1;
+					rd.next();
+					if (!detail::is_ctrl(rd.peek(), ':'))
+						rd.error(errc::invalid_object, "invalid object!");
+					size_t begin = rd.offset();
+					rd.next();
+
+					if (index == M::value) {
+						//never read later, so it is checked now the way from_json skips it
+						skip(rd);
+					}
+					else if (detail::is_ctrl(rd.peek(), '[') || detail::is_ctrl(rd.peek(), '{')) {
+						//anything the bracket scan cannot handle is tokenized instead
+						if (!rd.skip_container()) {
+							bool array = rd.expect('[');
+							rd.next();
+							if (array)
+								skip_array(rd);
+							else
+								skip_object(rd);
+						}
+					}
+					else {
+						skip(rd);
+					}
+
+					if (index != M::value) {
+						//from_json reads every occurrence of a key in turn, so an earlier
+						//one is read now and the last one is left for get()
+						if (begin_[index] != npos) {
+							reader_t member(buf_ + begin_[index], end_[index] - begin_[index]);
+							detail::dispatch_member(member, t_, index, std::make_index_sequence<M::value>{});
+						}
+						begin_[index] = begin;
+						//up to and including the ',' or '}' after the value, which has been
+						//consumed: a bare word or number only ends at it, as in from_json
+						end_[index] = rd.offset();
+					}
+
+					if (detail::is_ctrl(rd.peek(), ','))
+						rd.next();
+					else if (!detail::is_ctrl(rd.peek(), '}'))
+						rd.error(errc::invalid_object, "no valid object!");
 				}
-				break;
-			}
-			case token::t_int:
-			{
-				val = (tok.value.i64 != 0);
-				break;
 			}
-			case token::t_uint:
-			{
-				val = (tok.value.u64 != 0);
-				break;
+
+			//whether member I was in the document
+			template<size_t I>
+			bool contains() const {
+				return begin_[I] != npos;
 			}
-			case token::t_number:
-			{
-				val = (tok.value.d64 != 0.0);
-				break;
+
+			//member I, read on first use; members missing from the document keep their
+			//default value. a member that fails to read throws and is not read again
+			template<size_t I>
+			auto &get() {
+				auto &member = t_.*std::get<I>(M::apply());
+				if (!decoded_[I]) {
+					decoded_[I] = true;
+					if (begin_[I] != npos) {
+						reader_t rd(buf_ + begin_[I], end_[I] - begin_[I]);
+						read_json(rd, member);
+					}
+				}
+				return member;
 			}
-			default:
-			{
-				rd.error("not a valid bool.");
+
+			//reads every member not read yet
+			T &value() {
+				decode_all(std::make_index_sequence<M::value>{});
+				return t_;
 			}
+
+		private:
+			template<size_t... Is>
+			void decode_all(std::index_sequence<Is...>) {
+				int expand[] = { (get<Is>(), 0)... };
+				(void)expand;
 			}
-			rd.next();
+
+			const char *buf_;
+			size_t begin_[M::value];
+			size_t end_[M::value];
+			bool decoded_[M::value];
+			T t_;
+		};
+
+		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+		view<T> lazy_from_json(const char *buf, size_t len = -1) {
+			return view<T>(buf, len);
 		}
 
-		void read_json(reader_t &rd, std::string &val) {
-			auto &tok = rd.peek();
-			if (tok.type == token::t_string) {
-				val.assign(tok.str.str, tok.str.len);
+		///*********************************** stream parser *********************************///
+		//reads objects from input that arrives in pieces, such as a socket, without
+		//waiting for the whole input: feed() takes each piece as it comes and calls f
+		//with every object completed so far. the input is a sequence of objects, or of
+		//arrays of objects whose elements are handed over one by one, separated by
+		//white space. an object that lies within one piece is read from it in place,
+		//only the bytes of an object split across pieces are kept, so memory is
+		//bounded by the largest object rather than the whole input. string views in
+		//the objects are only valid during the call to f
+		template<typename T>
+		class stream_parser {
+			static_assert(is_reflection<T>::value, "stream_parser needs a reflected type");
+
+		public:
+			using callback_type = std::function<void(T&&)>;
+
+			explicit stream_parser(callback_type f) : f_(std::move(f)) {
 			}
-			else {
-				rd.error("not a valid string.");
+
+			stream_parser(const stream_parser&) = delete;
+			stream_parser& operator=(const stream_parser&) = delete;
+
+			//throws std::invalid_argument on malformed input, after which the parser
+			//has to be reset
+			void feed(const char *data, size_t len) {
+				if (feed(data, len, std::nothrow))
+					throw_error();
 			}
-			rd.next();
-		}
 
-		template <typename T, size_t N>
-		void read_json(reader_t &rd, T(&val)[N])
-		{
-			auto& tok = rd.peek();
-			if (tok.type == token::t_string)
-			{
-				size_t len = tok.str.len;
-				if (len > N)
-					len = N;
-				memcpy(val, tok.str.str, len);
-				if (len < N)
-					val[len] = 0;
+			//the error is kept and returned again until reset()
+			parse_error feed(const char *data, size_t len, const std::nothrow_t&) {
+				if (!error_)
+					scan(data, data + len);
+				return error_;
 			}
-			else
-			{
-				rd.error("not a valid string.");
+
+			//the end of the input; fails if it stopped inside an object or an array
+			void finish() {
+				if (finish(std::nothrow))
+					throw_error();
 			}
-			rd.next();
-		}
 
-		template<typename T>
-		std::enable_if_t<is_emplace_back_able<T>::value> emplace_back(T &val) {
-			val.emplace_back();
-		}
+			parse_error finish(const std::nothrow_t&) {
+				if (!error_ && (depth_ != 0 || in_array_ || (lex_ != l_none && lex_ != l_line_comment)))
+					fail(errc::unexpected_end, "unexpected end of input!", offset_);
+				return error_;
+			}
 
-		template<typename T>
-		std::enable_if_t<is_template_instant_of<std::queue, T>::value> emplace_back(T &val) {
-			val.emplace();
-		}
+			//forgets the object in flight and any error, for a new input
+			void reset() {
+				pending_.clear();
+				offset_ = 0;
+				value_offset_ = 0;
+				depth_ = 0;
+				in_array_ = false;
+				top_ = t_any;
+				lex_ = l_none;
+				error_ = parse_error();
+				message_.clear();
+			}
 
-		template<typename T>
-		std::enable_if_t<is_sequence_container<T>::value> read_json(reader_t &rd, T &val) {
-			if (rd.expect('[') == false) {
-				rd.error("array must start with [.");
+			//bytes fed since the start or the last reset
+			inline size_t offset() const {
+				return offset_;
 			}
-			rd.next();
-			auto tok = &rd.peek();
-			while (tok->str.str[0] != ']') {
-				emplace_back(val);
-				read_json(rd, val.back());
-				tok = &rd.peek();
-				if (tok->str.str[0] == ',') {
-					rd.next();
-					tok = &rd.peek();
-					continue;
-				}
-				else if (tok->str.str[0] == ']') {
-					break;
-				}
-				else {
-					rd.error("no valid array!");
+
+		private:
+			//what may come between two objects
+			enum top_state : uint8_t {
+				t_any,		//an object or an array
+				t_first,	//an object or the end of an empty array
+				t_next,		//',' or the end of the array
+				t_value,	//an object after ','
+			};
+
+			//inside a string or a comment, where brackets do not count
+			enum lex_state : uint8_t {
+				l_none,
+				l_string,
+				l_escape,
+				l_slash,
+				l_line_comment,
+				l_block_comment,
+				l_block_star,
+			};
+
+			void scan(const char *p, const char *end) {
+				const char *begin = p;
+				//where the bytes of the object in flight start in this piece
+				const char *value = depth_ != 0 ? p : nullptr;
+				while (p < end) {
+					switch (lex_) {
+					case l_string:
+						p = detail::find_string_end(p, end);
+						if (p == end)
+							continue;
+						if (*p == '"')
+							lex_ = l_none;
+						else if (*p == '\\')
+							lex_ = l_escape;
+						++p;
+						continue;
+					case l_escape:
+						lex_ = l_string;
+						++p;
+						continue;
+					case l_slash:
+						if (*p == '/')
+							lex_ = l_line_comment;
+						else if (*p == '*')
+							lex_ = l_block_comment;
+						else
+							return fail(errc::invalid_comment, "not a comment!", offset_ + (p - begin));
+						++p;
+						continue;
+					case l_line_comment:
+						p = static_cast<const char*>(memchr(p, '\n', end - p));
+						if (p == nullptr) {
+							p = end;
+							continue;
+						}
+						lex_ = l_none;
+						++p;
+						continue;
+					case l_block_comment:
+						p = static_cast<const char*>(memchr(p, '*', end - p));
+						if (p == nullptr) {
+							p = end;
+							continue;
+						}
+						lex_ = l_block_star;
+						++p;
+						continue;
+					case l_block_star:
+						if (*p == '/')
+							lex_ = l_none;
+						else if (*p != '*')
+							lex_ = l_block_comment;
+						++p;
+						continue;
+					default:
+						break;
+					}
+
+					if (depth_ != 0) {
+						//inside an object only brackets, quotes and slashes matter
+						while (p < end && static_cast<unsigned char>(detail::char_classes[static_cast<unsigned char>(*p)] - detail::cc_ctrl) > detail::cc_quote - detail::cc_ctrl)
+							++p;
+						if (p == end)
+							continue;
+					}
+
+					char c = *p;
+					if (c == '/') {
+						lex_ = l_slash;
+						++p;
+						continue;
+					}
+					if (depth_ != 0) {
+						if (c == '"') {
+							lex_ = l_string;
+						}
+						else if (c == '{' || c == '[') {
+							++depth_;
+						}
+						else if ((c == '}' || c == ']') && --depth_ == 0) {
+							++p;
+							top_ = in_array_ ? t_next : t_any;
+							if (!emit(value, p))
+								return;
+							value = nullptr;
+							continue;
+						}
+						++p;
+						continue;
+					}
+
+					if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+						++p;
+						continue;
+					}
+					if (c == '{' && top_ != t_next) {
+						value = p;
+						value_offset_ = offset_ + (p - begin);
+						depth_ = 1;
+					}
+					else if (c == '[' && top_ == t_any) {
+						in_array_ = true;
+						top_ = t_first;
+					}
+					else if (c == ']' && (top_ == t_first || top_ == t_next)) {
+						in_array_ = false;
+						top_ = t_any;
+					}
+					else if (c == ',' && top_ == t_next) {
+						top_ = t_value;
+					}
+					else if (in_array_) {
+						return fail(errc::invalid_array, "no valid array!", offset_ + (p - begin));
+					}
+					else {
+						return fail(errc::expected_object, "object must start with {!", offset_ + (p - begin));
+					}
+					++p;
 				}
+				if (depth_ != 0)
+					pending_.append(value, end - value);
+				offset_ += end - begin;
 			}
-			rd.next();
-		}
 
-		template<typename T>
-		std::enable_if_t<is_associat_container<T>::value> read_json(reader_t &rd, T &val) {
-			if (rd.expect('{') == false)
-			{
-				rd.error("object must start with {!");
-			}
-			rd.next();
-			auto tok = &rd.peek();
-			while (tok->str.str[0] != '}')
-			{
-				typename T::key_type key;
-				read_json(rd, key);
-				if (rd.expect(':') == false)
-				{
-					rd.error("invalid object!");
-				}
-				rd.next();
-				typename T::mapped_type value;
-				read_json(rd, value);
-				val[key] = value;
-				tok = &rd.peek();
-				if (tok->str.str[0] == ',')
-				{
-					rd.next();
-					tok = &rd.peek();
-					continue;
+			//empties pending_ once the object read from it is done with, also when f throws
+			struct pending_guard {
+				std::string &pending;
+
+				~pending_guard() {
+					pending.clear();
 				}
-				else if (tok->str.str[0] == '}')
-				{
-					break;
+			};
+
+			//reads the object ending at p, which started at value or in pending_
+			bool emit(const char *value, const char *p) {
+				const char *data = value;
+				size_t len = p - value;
+				if (!pending_.empty()) {
+					pending_.append(value, len);
+					data = pending_.data();
+					len = pending_.size();
 				}
-				else
-				{
-					rd.error("no valid object!");
+				//string views in t may point into pending_ until f returns
+				pending_guard guard{ pending_ };
+				T t{};
+				reader_t rd(data, len, std::nothrow);
+				do_read(rd, t);
+				if (rd.failed()) {
+					error_ = rd.get_error();
+					error_.offset += value_offset_;
+					message_ = rd.describe_error();
+					return false;
 				}
+				f_(std::move(t));
+				return true;
 			}
-			rd.next();
-		}
-
-		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-		void read_json(reader_t &rd, T &val) {
-			do_read(rd, val);
-			rd.next();
-		}
 
-		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-		void do_read(reader_t &rd, T &&t) {
-			for_each(std::forward<T>(t), [&rd](auto &v, size_t I, bool is_last) {
-				rd.next();
-				if (rd.peek().str != get_name<T>(I))
-					return;
+			void fail(errc code, const char *message, size_t offset) {
+				error_.code = code;
+				error_.offset = offset;
+				message_ = message;
+			}
 
-				rd.next();
-				rd.next();
-				read_json(rd, v);
-			}, [&rd](auto &o, size_t I, bool is_last) {
-				rd.next();
-				rd.next();
-				rd.next();
-				do_read(rd, o);
-				rd.next();
-			});
-		}
+			[[noreturn]] void throw_error() const {
+				iguana::detail::throw_invalid_argument("json stream at byte " + std::to_string(error_.offset) + ": " + message_);
+			}
 
-		template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-		void from_json(T &&t, const char *buf, size_t len = -1) {
-			reader_t rd(buf, len);
-			do_read(rd, t);
-		}
+			callback_type f_;
+			std::string pending_;
+			size_t offset_ = 0;
+			size_t value_offset_ = 0;
+			size_t depth_ = 0;
+			bool in_array_ = false;
+			top_state top_ = t_any;
+			lex_state lex_ = l_none;
+			parse_error error_;
+			std::string message_;
+		};
 	}
 }
 #endif //SERIALIZE_JSON_HPP
@@ -316,6 +316,24 @@ template<typename...> using void_t = void;
 
 template<typename> struct Members {};
 
+//a string literal with its length known at compile time
+struct name_fragment
+{
+    const char* data;
+    size_t size;
+};
+
+template<size_t N>
+constexpr name_fragment make_name_fragment(const char(&str)[N])
+{
+    return { str, N - 1 };
+}
+
+//pre-rendered field names, written with one fixed-size copy
+#define MAKE_JSON_KEY(t) make_name_fragment("\"" #t "\":")
+#define MAKE_XML_HEAD(t) make_name_fragment("<" #t ">")
+#define MAKE_XML_TAIL(t) make_name_fragment("</" #t ">")
+
 #define MAKE_META_DATA_IMPL(STRUCT_NAME, ...)\
 template<>struct Members<STRUCT_NAME>{\
     constexpr decltype(auto) static apply(){\
@@ -325,10 +343,16 @@ template<>struct Members<STRUCT_NAME>{\
     constexpr static const char *name = #STRUCT_NAME;\
     constexpr static const size_t value = GET_ARG_COUNT(__VA_ARGS__);\
     constexpr static const std::array<const char*, value>& arr = arr_##STRUCT_NAME;\
+    constexpr static const std::array<name_fragment, value>& json_keys = json_keys_##STRUCT_NAME;\
+    constexpr static const std::array<name_fragment, value>& xml_heads = xml_heads_##STRUCT_NAME;\
+    constexpr static const std::array<name_fragment, value>& xml_tails = xml_tails_##STRUCT_NAME;\
 };
 
 #define MAKE_META_DATA(STRUCT_NAME, N, ...) \
     constexpr std::array<const char*, N> arr_##STRUCT_NAME = {MARCO_EXPAND(MACRO_CONCAT(CON_STR, N)(__VA_ARGS__))};\
+    constexpr std::array<name_fragment, N> json_keys_##STRUCT_NAME = {{MAKE_ARG_LIST(N, MAKE_JSON_KEY, __VA_ARGS__)}};\
+    constexpr std::array<name_fragment, N> xml_heads_##STRUCT_NAME = {{MAKE_ARG_LIST(N, MAKE_XML_HEAD, __VA_ARGS__)}};\
+    constexpr std::array<name_fragment, N> xml_tails_##STRUCT_NAME = {{MAKE_ARG_LIST(N, MAKE_XML_TAIL, __VA_ARGS__)}};\
     MAKE_META_DATA_IMPL(STRUCT_NAME, MAKE_ARG_LIST(N, &STRUCT_NAME::OBJECT, __VA_ARGS__))
 
 //MAKE_TUPLE_CONST(MAKE_ARG_LIST(N, OBJECT, __VA_ARGS__))
@@ -352,10 +376,12 @@ struct is_reflection<T, void_t<
 //template<size_t I, typename F, typename T>
 //std::enable_if_t<is_reflection<T>::value> apply_value(F&& f, T&& t, bool is_last);
 
+//the index is passed as std::integral_constant, it converts to size_t for callbacks
+//taking a plain index and stays a compile time constant for generic ones
 template<size_t I, typename F, typename T>
 void apply_value(F&& f, T&& t, bool is_last)
 {
-    std::forward<F>(f)(std::forward<T>(t), I, is_last);
+    std::forward<F>(f)(std::forward<T>(t), std::integral_constant<size_t, I>{}, is_last);
 };
 
 //template<size_t I, typename F, typename T>
@@ -380,13 +406,13 @@ constexpr void for_each_impl(F&& f, T&&t, bool is_last)
 template<size_t I, typename F, typename F1, typename T>
 std::enable_if_t<is_reflection<T>::value> apply_value(F&& f, F1&& f1, T&& t, bool is_last)
 {
-    std::forward<F1>(f1)(std::forward<T>(t), I, is_last);
+    std::forward<F1>(f1)(std::forward<T>(t), std::integral_constant<size_t, I>{}, is_last);
 }
 
 template<size_t I, typename F, typename F1, typename T>
 std::enable_if_t<!is_reflection<T>::value> apply_value(F&& f, F1&& f1, T&& t, bool is_last)
 {
-    std::forward<F>(f)(std::forward<T>(t), I, is_last);
+    std::forward<F>(f)(std::forward<T>(t), std::integral_constant<size_t, I>{}, is_last);
 }
 
 //template<size_t I, typename F, typename F1, typename T>
@@ -426,6 +452,17 @@ constexpr void apply(F&& f, T&& t, std::tuple<Rest...>&&, std::index_sequence<>)
 {
 }
 
+//the ends of the recursion come first, so the recursive calls can see them
+template<typename F, typename... Rest>
+constexpr void apply_tuple(F&& f, std::tuple<Rest...>&, std::index_sequence<>)
+{
+}
+
+template<typename F, typename... Rest>
+constexpr void apply_tuple(F&& f, const std::tuple<Rest...>&, std::index_sequence<>)
+{
+}
+
 template<typename F, typename... Rest,std::size_t I0, std::size_t... I>
 constexpr void apply_tuple(F&& f, std::tuple<Rest...>& tp, std::index_sequence<I0, I...>)
 {
@@ -433,9 +470,11 @@ constexpr void apply_tuple(F&& f, std::tuple<Rest...>& tp, std::index_sequence<I
     apply_tuple(std::forward<F>(f), tp, std::index_sequence<I...>{});
 }
 
-template<typename F, typename... Rest>
-constexpr void apply_tuple(F&& f, std::tuple<Rest...>&, std::index_sequence<>)
+template<typename F, typename... Rest,std::size_t I0, std::size_t... I>
+constexpr void apply_tuple(F&& f, const std::tuple<Rest...>& tp, std::index_sequence<I0, I...>)
 {
+    apply_value<I0>(std::forward<F>(f), std::get<I0>(tp), sizeof...(I)==0);
+    apply_tuple(std::forward<F>(f), tp, std::index_sequence<I...>{});
 }
 
 template<size_t I, typename T>
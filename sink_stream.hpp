@@ -0,0 +1,140 @@
+//
+// bounded memory output for to_json/to_xml
+//
+
+#ifndef SERIALIZE_SINK_STREAM_HPP
+#define SERIALIZE_SINK_STREAM_HPP
+#include <string.h>
+#include <errno.h>
+#include <functional>
+#include <memory>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace iguana {
+	//a fixed size buffer handed to a sink whenever it fills up, so peak memory
+	//does not depend on the size of the output; the sink returns false on
+	//failure, after which further output is dropped and good() is false
+	class sink_stream
+	{
+	public:
+		using sink_type = std::function<bool(const char *, std::size_t)>;
+
+		//a capacity of 0 is taken as 1, put() needs room for a byte
+		explicit sink_stream(sink_type sink, std::size_t capacity = 64 * 1024)
+			: m_sink(std::move(sink))
+			, m_buffer(new char[capacity != 0 ? capacity : 1])
+			, m_write_ptr(m_buffer.get())
+			, m_tail_ptr(m_buffer.get() + (capacity != 0 ? capacity : 1))
+			, m_flushed(0)
+			, m_good(true)
+		{
+		}
+
+#ifndef _WIN32
+		//writes to fd, retrying short writes and EINTR
+		explicit sink_stream(int fd, std::size_t capacity = 64 * 1024)
+			: sink_stream([fd](const char * data, std::size_t len)
+			{
+				while (len != 0)
+				{
+					ssize_t written = ::write(fd, data, len);
+					if (written < 0)
+					{
+						if (errno == EINTR)
+							continue;
+						return false;
+					}
+					data += written;
+					len -= static_cast<std::size_t>(written);
+				}
+				return true;
+			}, capacity)
+		{
+		}
+#endif
+
+		sink_stream(const sink_stream&) = delete;
+		sink_stream& operator=(const sink_stream&) = delete;
+
+		//errors from this last flush are lost, call flush() to see them
+		~sink_stream()
+		{
+			flush();
+		}
+
+		inline std::size_t write(const char * buffer)
+		{
+			return write(buffer, strlen(buffer));
+		}
+
+		inline std::size_t write(const char * buffer, std::size_t len)
+		{
+			if (static_cast<std::size_t>(this->m_tail_ptr - this->m_write_ptr) < len)
+			{
+				flush();
+				//too big to buffer, hand it over directly
+				if (len >= this->capacity())
+				{
+					emit(buffer, len);
+					return len;
+				}
+			}
+			std::memcpy(this->m_write_ptr, buffer, len);
+			this->m_write_ptr += len;
+			return len;
+		}
+
+		inline void put(char c)
+		{
+			if (this->m_write_ptr == this->m_tail_ptr)
+				flush();
+			*this->m_write_ptr = c;
+			++this->m_write_ptr;
+		}
+
+		//hands the buffered bytes to the sink
+		bool flush()
+		{
+			std::size_t len = this->m_write_ptr - this->m_buffer.get();
+			this->m_write_ptr = this->m_buffer.get();
+			if (len != 0)
+				emit(this->m_buffer.get(), len);
+			return this->m_good;
+		}
+
+		inline bool good() const
+		{
+			return this->m_good;
+		}
+
+		inline std::size_t capacity() const
+		{
+			return this->m_tail_ptr - this->m_buffer.get();
+		}
+
+		//bytes written so far, flushed or still buffered
+		inline std::size_t size() const
+		{
+			return this->m_flushed + (this->m_write_ptr - this->m_buffer.get());
+		}
+
+	private:
+		void emit(const char * data, std::size_t len)
+		{
+			this->m_flushed += len;
+			if (this->m_good)
+				this->m_good = this->m_sink(data, len);
+		}
+
+		sink_type m_sink;
+		std::unique_ptr<char[]> m_buffer;
+		char * m_write_ptr;
+		char * m_tail_ptr;
+		std::size_t m_flushed;
+		bool m_good;
+	};
+}
+#endif //SERIALIZE_SINK_STREAM_HPP
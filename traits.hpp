@@ -5,13 +5,24 @@
 #ifndef SERIALIZE_TRAITS_HPP
 #define SERIALIZE_TRAITS_HPP
 
+#include <cstddef>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <set>
+#include <unordered_set>
 #include <deque>
 #include <queue>
 #include <list>
+
+#if (defined(__cplusplus) && __cplusplus >= 201703L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#define IGUANA_HAS_STRING_VIEW
+#endif
+
 namespace iguana
 {
     template< class T >
@@ -36,6 +47,23 @@ namespace iguana
     struct is_stdstring : is_template_instant_of < std::basic_string, T >
     {};
 
+    //std::basic_string<char> with any traits or allocator, e.g. std::pmr::string
+    template<typename T>
+    struct is_char_string : std::false_type {};
+
+    template<typename Traits, typename Alloc>
+    struct is_char_string<std::basic_string<char, Traits, Alloc>> : std::true_type {};
+
+    //non-owning strings constructible from (const char*, size_t), read without
+    //copying; specialize it for other view types
+    template<typename T>
+    struct is_string_view : std::false_type {};
+
+#ifdef IGUANA_HAS_STRING_VIEW
+    template<typename Traits>
+    struct is_string_view<std::basic_string_view<char, Traits>> : std::true_type {};
+#endif
+
     template< class T >
     struct is_sequence_container : std::integral_constant < bool,
             is_template_instant_of<std::deque, T>::value ||
@@ -47,7 +75,34 @@ namespace iguana
     template< class T >
     struct is_associat_container : std::integral_constant < bool,
             is_template_instant_of<std::map, T>::value ||
-            is_template_instant_of<std::unordered_map, T>::value
+            is_template_instant_of<std::unordered_map, T>::value ||
+            is_template_instant_of<std::multimap, T>::value ||
+            is_template_instant_of<std::unordered_multimap, T>::value
+    > {};
+
+    //written and read as arrays
+    template< class T >
+    struct is_set_container : std::integral_constant < bool,
+            is_template_instant_of<std::set, T>::value ||
+            is_template_instant_of<std::unordered_set, T>::value ||
+            is_template_instant_of<std::multiset, T>::value ||
+            is_template_instant_of<std::unordered_multiset, T>::value
+    > {};
+
+    template< class T >
+    struct is_ordered_container : std::integral_constant < bool,
+            is_template_instant_of<std::map, T>::value ||
+            is_template_instant_of<std::multimap, T>::value ||
+            is_template_instant_of<std::set, T>::value ||
+            is_template_instant_of<std::multiset, T>::value
+    > {};
+
+    template< class T >
+    struct is_multi_container : std::integral_constant < bool,
+            is_template_instant_of<std::multimap, T>::value ||
+            is_template_instant_of<std::unordered_multimap, T>::value ||
+            is_template_instant_of<std::multiset, T>::value ||
+            is_template_instant_of<std::unordered_multiset, T>::value
     > {};
 
     template< class T >
@@ -56,5 +111,33 @@ namespace iguana
             is_template_instant_of<std::list, T>::value ||
             is_template_instant_of<std::vector, T>::value
     > {};
+
+    template<typename T, typename = void>
+    struct has_reserve : std::false_type {};
+
+    template<typename T>
+    struct has_reserve<T, decltype(std::declval<T&>().reserve(std::size_t{}), void())> : std::true_type {};
+
+    //streams that can keep a pointer to bytes outliving them instead of copying
+    template<typename Stream, typename = void>
+    struct has_write_ref : std::false_type {};
+
+    template<typename Stream>
+    struct has_write_ref<Stream, decltype(std::declval<Stream&>().write_ref(
+            std::declval<const char*>(), std::size_t{}), void())> : std::true_type {};
+
+    //data must stay valid until the stream is consumed, e.g. a member of the
+    //object being serialized
+    template<typename Stream>
+    std::enable_if_t<has_write_ref<Stream>::value> write_stable(Stream& ss, const char* data, std::size_t len)
+    {
+        ss.write_ref(data, len);
+    }
+
+    template<typename Stream>
+    std::enable_if_t<!has_write_ref<Stream>::value> write_stable(Stream& ss, const char* data, std::size_t len)
+    {
+        ss.write(data, len);
+    }
 }
 #endif //SERIALIZE_TRAITS_HPP
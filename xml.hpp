@@ -6,7 +6,11 @@
 #include "reflection.hpp"
 #include "traits.hpp"
 #include "itoa.hpp"
-#include <boost/lexical_cast.hpp>
+#include "dtoa.hpp"
+#include "atod.hpp"
+#include "error.hpp"
+#include "arena.hpp"
+#include <limits>
 
 #define IGUANA_XML_READER_CHECK_FORWARD if (l > length) return 0; work_ptr += l; length -= l
 #define IGUANA_XML_READER_CHECK_FORWARD_CHAR if(length < 1) return 0; work_ptr += 1; length -= 1
@@ -57,17 +61,23 @@ namespace iguana { namespace xml
 			return length;
 		}
 
+		//<cctype> takes bytes as unsigned char, a plain char is negative past 0x7f
+		inline bool is_blank_ctrl(char c)
+		{
+			return std::isblank(static_cast<unsigned char>(c)) || std::iscntrl(static_cast<unsigned char>(c));
+		}
+
 		inline size_t ignore_blank_ctrl(char const* begin, size_t length)
 		{
-			return forward(begin, length, [](auto c) { return !std::isblank(c) && !std::iscntrl(c); });
+			return forward(begin, length, [](char c) { return !is_blank_ctrl(c); });
 		}
 
 		inline size_t get_token(char const* str, size_t length)
 		{
-			if (!(std::isalpha(*str) || expected_char(str++, char_const::underline)))
+			if (!(std::isalpha(static_cast<unsigned char>(*str)) || expected_char(str++, char_const::underline)))
 				return 0;
 
-			return forward(str, length - 1, [](auto c) { return !std::isalnum(c) && char_const::underline != c; });
+			return forward(str, length - 1, [](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && char_const::underline != c; });
 		}
 
 		inline bool expected_token(char const* str, size_t length, char const* expected, size_t expected_length)
@@ -93,16 +103,130 @@ namespace iguana { namespace xml
 			return l;
 		}
 
+		template <typename T>
+		struct is_char : std::integral_constant<bool,
+			std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value>
+		{};
+
+		//the value parsers return false instead of throwing when the text does not fit T
+		inline bool get_value(char const* str, size_t length, bool& value)
+		{
+			if ((length == 1 && str[0] == '1') || expected_token(str, length, "true", 4))
+				value = true;
+			else if ((length == 1 && str[0] == '0') || expected_token(str, length, "false", 5))
+				value = false;
+			else
+				return false;
+			return true;
+		}
+
+		template <typename T>
+		auto get_value(char const* str, size_t length, T& value)
+			-> std::enable_if_t<is_char<T>::value, bool>
+		{
+			if (length != 1)
+				return false;
+			value = static_cast<T>(str[0]);
+			return true;
+		}
+
+		template <typename T>
+		auto get_value(char const* str, size_t length, T& value)
+			-> std::enable_if_t<std::is_integral<T>::value && !is_char<T>::value && !std::is_same<T, bool>::value, bool>
+		{
+			char const* end = str + length;
+			bool negative = str != end && *str == '-';
+			if (negative && !std::is_signed<T>::value)
+				return false;
+			if (str != end && (*str == '-' || *str == '+'))
+				++str;
+			if (str == end)
+				return false;
+
+			//the magnitude limit of T, one more for negative values
+			const uint64_t limit = static_cast<uint64_t>((std::numeric_limits<T>::max)()) + (negative ? 1 : 0);
+			uint64_t v = 0;
+			for (; str != end; ++str)
+			{
+				if (*str < '0' || *str > '9')
+					return false;
+				uint64_t digit = static_cast<uint64_t>(*str - '0');
+				if (v > (limit - digit) / 10)
+					return false;
+				v = v * 10 + digit;
+			}
+			value = negative ? static_cast<T>(0 - v) : static_cast<T>(v);
+			return true;
+		}
+
+		inline bool equals_nocase(char const* str, size_t length, char const* lower)
+		{
+			size_t i = 0;
+			for (; i < length && lower[i] != 0; ++i)
+			{
+				if (std::tolower(static_cast<unsigned char>(str[i])) != lower[i])
+					return false;
+			}
+			return i == length && lower[i] == 0;
+		}
+
+		//also takes a leading '+', a missing integer part (.5) and the nan, inf and
+		//-inf to_xml writes for values that are not finite
 		template <typename T>
 		auto get_value(char const* str, size_t length, T& value)
-			-> std::enable_if_t<std::is_arithmetic<T>::value>
+			-> std::enable_if_t<std::is_floating_point<T>::value, bool>
 		{
-			value = boost::lexical_cast<T>(str, length);
+			char const* end = str + length;
+			bool negative = str != end && *str == '-';
+			if (str != end && (*str == '-' || *str == '+'))
+				++str;
+			length = end - str;
+			if (equals_nocase(str, length, "nan"))
+			{
+				value = std::numeric_limits<T>::quiet_NaN();
+				return true;
+			}
+			if (equals_nocase(str, length, "inf") || equals_nocase(str, length, "infinity"))
+			{
+				value = negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+				return true;
+			}
+
+			std::string digits;
+			if (str != end && *str == '.')
+			{
+				if (length < 2 || !std::isdigit(static_cast<unsigned char>(str[1])))
+					return false;
+				digits.reserve(length + 1);
+				digits += '0';
+				digits.append(str, length);
+				str = digits.data();
+				end = str + digits.size();
+			}
+			iguana::detail::decimal_number d;
+			char const* last = iguana::detail::scan_number(str, end, d);
+			if (last != end || d.negative)
+				return false;
+			double v = iguana::detail::to_double(d, str, last);
+			value = static_cast<T>(negative ? -v : v);
+			return true;
 		}
 
-		void get_value(char const* str, size_t length, std::string& value)
+		template <typename T>
+		auto get_value(char const* str, size_t length, T& value)
+			-> std::enable_if_t<is_char_string<T>::value, bool>
 		{
+			iguana::detail::adopt_current_arena(value);
 			value.assign(str, length);
+			return true;
+		}
+
+		template <typename T>
+		auto get_value(char const* str, size_t length, T& value)
+			-> std::enable_if_t<is_string_view<T>::value, bool>
+		{
+			value = T(str, length);
+			return true;
 		}
 
 		template <typename T>
@@ -129,7 +253,8 @@ namespace iguana { namespace xml
 
 	public:
 		xml_reader_t(char const* buffer, size_t length)
-			: buffer_(buffer)
+			: begin_(buffer)
+			, buffer_(buffer)
 			, length_(length)
 		{
 		}
@@ -202,14 +327,12 @@ namespace iguana { namespace xml
 			IGUANA_XML_READER_CHECK_FORWARD;
 
 			l = detail::forward_until(work_ptr, length, detail::char_const::angle_bracket);
-			try
-			{
-				detail::get_value(work_ptr, l, t);
-			}
-			catch (...)
-			{
+			//trailing blanks before the closing tag are not part of the value
+			size_t value_length = l;
+			while (value_length > 0 && detail::is_blank_ctrl(work_ptr[value_length - 1]))
+				--value_length;
+			if (!detail::get_value(work_ptr, value_length, t))
 				return false;
-			}
 			IGUANA_XML_READER_CHECK_FORWARD;
 
 			buffer_ = work_ptr;
@@ -248,11 +371,35 @@ namespace iguana { namespace xml
 			return true;
 		}
 
+		//keeps the first error, at the position reading stopped
+		bool error(errc code)
+		{
+			if (error_.code == errc::ok)
+			{
+				error_.code = code;
+				error_.offset = buffer_ - begin_;
+			}
+			return false;
+		}
+
+		//called by readers returning from a failed member, innermost first
+		void push_path(char const* name)
+		{
+			iguana::detail::push_path(error_.path, name, std::strlen(name));
+		}
+
+		parse_error const& get_error() const
+		{
+			return error_;
+		}
+
 		static const size_t xml_header_length = detail::array_size<decltype(IGUANA_XML_HEADER)>::value;
 
 	private:
+		char const*	begin_;
 		char const*	buffer_;
 		size_t		length_;
+		parse_error	error_;
 	};
 
 	//to xml
@@ -268,15 +415,26 @@ namespace iguana { namespace xml
 	template<typename Stream, typename T>
 	std::enable_if_t<std::is_floating_point<T>::value> render_xml_value(Stream& ss, T value)
 	{
-		char temp[20];
-		sprintf(temp, "%f", value);
-		ss.write(temp);
+#ifdef IGUANA_FLOAT_PRECISION
+		char temp[dtoa_fixed_buffer_size(IGUANA_FLOAT_PRECISION)];
+		auto p = dtoa_fixed(value, IGUANA_FLOAT_PRECISION, temp);
+#else
+		char temp[dtoa_buffer_size];
+		auto p = dtoa_fwd(value, temp);
+#endif
+		ss.write(temp, p - temp);
 	}
 
-	template<typename Stream>
-	void render_xml_value(Stream& ss, const std::string &s)
+	template<typename Stream, typename T>
+	std::enable_if_t<is_char_string<T>::value> render_xml_value(Stream& ss, const T &s)
+	{
+		write_stable(ss, s.c_str(), s.size());
+	}
+
+	template<typename Stream, typename T>
+	std::enable_if_t<is_string_view<T>::value> render_xml_value(Stream& ss, const T &s)
 	{
-		ss.write(s.c_str(), s.size());
+		write_stable(ss, s.data(), s.size());
 	}
 
 	template<typename Stream>
@@ -292,8 +450,8 @@ namespace iguana { namespace xml
 		ss.put('>');
 	}
 
-	template<typename Stream>
-	void render_key(Stream& ss, const std::string &s) {
+	template<typename Stream, typename T>
+	std::enable_if_t<is_char_string<T>::value> render_key(Stream& ss, const T &s) {
 		render_xml_value(ss, s);
 	}
 
@@ -319,17 +477,33 @@ namespace iguana { namespace xml
 		ss.put('>');
 	}
 
+	template<typename T, typename Stream, size_t I>
+	void render_tail(Stream& ss, std::integral_constant<size_t, I>)
+	{
+		using M = Members<std::remove_const_t<std::remove_reference_t<T>>>;
+		constexpr name_fragment tail = M::xml_tails[I];
+		ss.write(tail.data, tail.size);
+	}
+
+	template<typename T, typename Stream, size_t I>
+	void render_head(Stream& ss, std::integral_constant<size_t, I>)
+	{
+		using M = Members<std::remove_const_t<std::remove_reference_t<T>>>;
+		constexpr name_fragment head = M::xml_heads[I];
+		ss.write(head.data, head.size);
+	}
+
 	template<typename Stream, typename T, typename = std::enable_if_t<is_reflection<T>::value>>
 	void to_xml_impl(Stream& s, T &&t) {
-		for_each(std::forward<T>(t), [&s](const auto& v, size_t I, bool is_last) { //magic for_each struct std::forward<T>(t)
-			render_head(s, get_name<T>(I));
+		for_each(std::forward<T>(t), [&s](const auto& v, auto I, bool is_last) { //magic for_each struct std::forward<T>(t)
+			render_head<T>(s, I);
 			render_xml_value(s, v);
-			render_tail(s, get_name<T>(I));
-		}, [&s](const auto& o, size_t I, bool is_last)
+			render_tail<T>(s, I);
+		}, [&s](const auto& o, auto I, bool is_last)
 		{
-			render_head(s, get_name<T>(I));
+			render_head<T>(s, I);
 			to_xml_impl(s, o);
-			render_tail(s, get_name<T>(I));
+			render_tail<T>(s, I);
 		});
 	}
 
@@ -340,27 +514,38 @@ namespace iguana { namespace xml
 		to_xml_impl(s, std::forward<T>(t));
 	}
 
+	//members whose element is missing are left as they are; a value that does not
+	//parse or an unclosed element stops the read
 	template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
-	void do_read(xml_reader_t &rd, T &&t)
+	bool do_read(xml_reader_t &rd, T &&t)
 	{
+		bool ok = true;
 		for_each(std::forward<T>(t),
-			[&rd](auto& value, size_t I, bool is_last) 
+			[&rd, &ok](auto& value, size_t I, bool is_last) 
 		{
-			if (rd.begin_object(get_name<T>(I)) == 1)
+			if (ok && rd.begin_object(get_name<T>(I)) == 1)
 			{
 				// read value
-				rd.get_value(value);
-				rd.end_object(get_name<T>(I));
+				if (!rd.get_value(value))
+					ok = rd.error(errc::type_mismatch);
+				else if (!rd.end_object(get_name<T>(I)))
+					ok = rd.error(errc::invalid_object);
+				if (!ok)
+					rd.push_path(get_name<T>(I));
 			}
 		},
-			[&rd](auto &obj, size_t I, bool is_last) 
+			[&rd, &ok](auto &obj, size_t I, bool is_last) 
 		{
-			if (rd.begin_object(get_name<T>(I)) == 1)
+			if (ok && rd.begin_object(get_name<T>(I)) == 1)
 			{
-				do_read(rd, obj);
-				rd.end_object(get_name<T>(I));
+				if (do_read(rd, obj) && !rd.end_object(get_name<T>(I)))
+					rd.error(errc::invalid_object);
+				ok = rd.get_error().code == errc::ok;
+				if (!ok)
+					rd.push_path(get_name<T>(I));
 			}
 		});
+		return ok;
 	}
 
 	template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
@@ -372,4 +557,25 @@ namespace iguana { namespace xml
 			do_read(rd, t);
 		}
 	}
+
+	//never throws; the error converts to true if t could not be read, and t is
+	//then left partly filled
+	template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+	parse_error from_xml(T &&t, const char *buf, size_t len, const std::nothrow_t&)
+	{
+		xml_reader_t rd(buf, len);
+		if (!rd.get_root())
+			rd.error(errc::invalid_document);
+		else
+			do_read(rd, t);
+		return rd.get_error();
+	}
+
+	//strings using arena_allocator are allocated from a
+	template<typename T, typename = std::enable_if_t<is_reflection<T>::value>>
+	void from_xml(T &&t, const char *buf, size_t len, arena &a)
+	{
+		arena_scope scope(a);
+		from_xml(t, buf, len);
+	}
 } }